@@ -0,0 +1,256 @@
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "BinaryCG.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+using namespace llvm;
+using namespace std;
+
+const char BinaryCG::magic[8] = {'K', 'L', 'E', 'A', 'K', 'C', 'G', '\0'};
+
+// whether the tables stay within each other, so that no lookup reads out of the file, and the callers are sorted
+// by name for findCallees()
+static bool isConsistent(const BinaryCGHeader *h, const uint64_t *rowStart, const uint32_t *nameOffsets, const uint32_t *callers, const uint32_t *callees, const char *strTab)
+{
+    if (rowStart[0] != 0 || rowStart[h->numCallers] != h->numEdges)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < h->numCallers; ++i)
+    {
+        if (rowStart[i] > rowStart[i + 1])
+        {
+            return false;
+        }
+    }
+    if (nameOffsets[0] != 0 || nameOffsets[h->numNames] != h->strTabSize)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < h->numNames; ++i)
+    {
+        if (nameOffsets[i] > nameOffsets[i + 1])
+        {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < h->numCallers; ++i)
+    {
+        if (callers[i] >= h->numNames)
+        {
+            return false;
+        }
+        if (i > 0)
+        {
+            StringRef prev(strTab + nameOffsets[callers[i - 1]], nameOffsets[callers[i - 1] + 1] - nameOffsets[callers[i - 1]]);
+            StringRef curr(strTab + nameOffsets[callers[i]], nameOffsets[callers[i] + 1] - nameOffsets[callers[i]]);
+            if (!(prev < curr))
+            {
+                return false;
+            }
+        }
+    }
+    for (uint64_t i = 0; i < h->numEdges; ++i)
+    {
+        if (callees[i] >= h->numNames)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+BinaryCG::BinaryCG(string filename) : header(nullptr), rowStart(nullptr), nameOffsets(nullptr), callers(nullptr), callees(nullptr), strTab(nullptr)
+{
+    // large files are mmap'ed by MemoryBuffer
+    ErrorOr<unique_ptr<MemoryBuffer>> bufferOrErr = MemoryBuffer::getFile(filename, false, false);
+    if (!bufferOrErr)
+    {
+        return;
+    }
+    const char *start = (*bufferOrErr)->getBufferStart();
+    uint64_t size = (*bufferOrErr)->getBufferSize();
+    if (size < sizeof(BinaryCGHeader) || (uintptr_t)start % alignof(uint64_t) != 0)
+    {
+        return;
+    }
+    const BinaryCGHeader *h = reinterpret_cast<const BinaryCGHeader *>(start);
+    if (memcmp(h->magic, BinaryCG::magic, sizeof(BinaryCG::magic)) != 0 || h->version != BinaryCG::version)
+    {
+        return;
+    }
+    if (h->numEdges > size || h->strTabSize > size) // or else the expected size may overflow
+    {
+        return;
+    }
+    uint64_t expectedSize = sizeof(BinaryCGHeader) + sizeof(uint64_t) * ((uint64_t)h->numCallers + 1) + sizeof(uint32_t) * ((uint64_t)h->numNames + 1) + sizeof(uint32_t) * (uint64_t)h->numCallers + sizeof(uint32_t) * h->numEdges + h->strTabSize;
+    if (size != expectedSize)
+    {
+        return;
+    }
+
+    const char *p = start + sizeof(BinaryCGHeader);
+    this->rowStart = reinterpret_cast<const uint64_t *>(p);
+    p += sizeof(uint64_t) * ((uint64_t)h->numCallers + 1);
+    this->nameOffsets = reinterpret_cast<const uint32_t *>(p);
+    p += sizeof(uint32_t) * ((uint64_t)h->numNames + 1);
+    this->callers = reinterpret_cast<const uint32_t *>(p);
+    p += sizeof(uint32_t) * (uint64_t)h->numCallers;
+    this->callees = reinterpret_cast<const uint32_t *>(p);
+    p += sizeof(uint32_t) * h->numEdges;
+    this->strTab = p;
+    if (!isConsistent(h, this->rowStart, this->nameOffsets, this->callers, this->callees, this->strTab))
+    {
+        return;
+    }
+    this->header = h;
+    this->buffer = std::move(*bufferOrErr);
+}
+
+bool BinaryCG::isValid() const
+{
+    return this->header != nullptr;
+}
+
+uint32_t BinaryCG::getNumCallers() const
+{
+    return this->header->numCallers;
+}
+
+uint32_t BinaryCG::getCaller(uint32_t i) const
+{
+    return this->callers[i];
+}
+
+ArrayRef<uint32_t> BinaryCG::getCallees(uint32_t i) const
+{
+    return ArrayRef<uint32_t>(this->callees + this->rowStart[i], this->callees + this->rowStart[i + 1]);
+}
+
+ArrayRef<uint32_t> BinaryCG::findCallees(StringRef callerName) const
+{
+    // callers are sorted by name
+    const uint32_t *end = this->callers + this->header->numCallers;
+    const uint32_t *it = std::lower_bound(this->callers, end, callerName, [this](uint32_t nameIdx, StringRef name) { return this->getName(nameIdx) < name; });
+    if (it != end && this->getName(*it) == callerName)
+    {
+        return this->getCallees(it - this->callers);
+    }
+    return ArrayRef<uint32_t>();
+}
+
+StringRef BinaryCG::getName(uint32_t nameIdx) const
+{
+    return StringRef(this->strTab + this->nameOffsets[nameIdx], this->nameOffsets[nameIdx + 1] - this->nameOffsets[nameIdx]);
+}
+
+bool BinaryCG::isBinaryCGFile(string filename)
+{
+    ifstream s(filename, ios::binary);
+    char buf[sizeof(BinaryCG::magic)];
+    if (!s.read(buf, sizeof(buf)))
+    {
+        return false;
+    }
+    return memcmp(buf, BinaryCG::magic, sizeof(buf)) == 0;
+}
+
+bool BinaryCG::convertText(string textFilename, string binaryFilename, ostream &out)
+{
+    ErrorOr<unique_ptr<MemoryBuffer>> bufferOrErr = MemoryBuffer::getFile(textFilename, true, false);
+    if (!bufferOrErr)
+    {
+        out << "[-] Cannot read " << textFilename << "\n";
+        return false;
+    }
+
+    // edges refer to the text buffer, so nothing is allocated per edge
+    vector<pair<StringRef, StringRef>> nameEdges;
+    StringMap<uint32_t> name2Idx;
+    StringRef rest = (*bufferOrErr)->getBuffer();
+    while (!rest.empty())
+    {
+        StringRef line;
+        std::tie(line, rest) = rest.split('\n');
+        if (line.find("->") == StringRef::npos)
+        {
+            continue;
+        }
+        StringRef src, dst;
+        std::tie(src, dst) = line.split("->");
+        dst = dst.split("->").first; // same as tokenize(line, "->")[1]
+        name2Idx.insert(std::make_pair(src, 0));
+        name2Idx.insert(std::make_pair(dst, 0));
+        nameEdges.push_back(std::make_pair(src, dst));
+    }
+
+    // names are numbered in sorted order, so callers and callees come out in the order of DSimpleCGMap
+    vector<StringRef> names;
+    for (auto &it : name2Idx)
+    {
+        names.push_back(it.getKey());
+    }
+    std::sort(names.begin(), names.end());
+    vector<uint32_t> nameOffsets(1, 0);
+    for (uint32_t i = 0; i < names.size(); ++i)
+    {
+        name2Idx[names[i]] = i;
+        nameOffsets.push_back(nameOffsets.back() + names[i].size());
+    }
+
+    vector<pair<uint32_t, uint32_t>> edges;
+    for (auto &edge : nameEdges)
+    {
+        edges.push_back(std::make_pair(name2Idx[edge.first], name2Idx[edge.second]));
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    vector<uint64_t> rowStart;
+    vector<uint32_t> callers;
+    vector<uint32_t> callees;
+    for (auto &edge : edges)
+    {
+        if (callers.empty() || callers.back() != edge.first)
+        {
+            callers.push_back(edge.first);
+            rowStart.push_back(callees.size());
+        }
+        callees.push_back(edge.second);
+    }
+    rowStart.push_back(callees.size());
+
+    BinaryCGHeader header;
+    memcpy(header.magic, BinaryCG::magic, sizeof(BinaryCG::magic));
+    header.version = BinaryCG::version;
+    header.numNames = names.size();
+    header.numCallers = callers.size();
+    header.reserved = 0;
+    header.numEdges = callees.size();
+    header.strTabSize = nameOffsets.back();
+
+    std::error_code ec;
+    raw_fd_ostream s(binaryFilename, ec, sys::fs::OF_None);
+    if (ec)
+    {
+        out << "[-] Cannot write " << binaryFilename << ": " << ec.message() << "\n";
+        return false;
+    }
+    s.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    s.write(reinterpret_cast<const char *>(rowStart.data()), sizeof(uint64_t) * rowStart.size());
+    s.write(reinterpret_cast<const char *>(nameOffsets.data()), sizeof(uint32_t) * nameOffsets.size());
+    s.write(reinterpret_cast<const char *>(callers.data()), sizeof(uint32_t) * callers.size());
+    s.write(reinterpret_cast<const char *>(callees.data()), sizeof(uint32_t) * callees.size());
+    for (StringRef name : names)
+    {
+        s << name;
+    }
+    out << "[+] Converted " << callees.size() << " edges of " << callers.size() << " callers\n";
+    return true;
+}
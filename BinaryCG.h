@@ -0,0 +1,59 @@
+#pragma once
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include <memory>
+#include <ostream>
+#include <string>
+
+// Binary call graph file. Each name is stored once in a sorted string table, and the callees of all callers
+// are stored in one adjacency array (CSR). The file is mapped into memory and read in place.
+//
+// Layout, in native byte order:
+//   BinaryCGHeader
+//   uint64_t rowStart[numCallers + 1]   callees of the i-th caller are callees[rowStart[i], rowStart[i + 1])
+//   uint32_t nameOffsets[numNames + 1]  the i-th name is strTab[nameOffsets[i], nameOffsets[i + 1])
+//   uint32_t callers[numCallers]        name indices, sorted
+//   uint32_t callees[numEdges]          name indices, sorted for each caller
+//   char strTab[strTabSize]
+class BinaryCGHeader
+{
+public:
+    char magic[8];
+    uint32_t version;
+    uint32_t numNames;
+    uint32_t numCallers;
+    uint32_t reserved;
+    uint64_t numEdges;
+    uint64_t strTabSize;
+};
+
+class BinaryCG
+{
+public:
+    static const char magic[8];
+    static const uint32_t version = 1;
+
+    BinaryCG(std::string filename); // check isValid() before use; a truncated or inconsistent file is invalid
+
+    bool isValid() const;
+    uint32_t getNumCallers() const;
+    uint32_t getCaller(uint32_t i) const; // name index of the i-th caller
+    llvm::ArrayRef<uint32_t> getCallees(uint32_t i) const; // name indices of the callees of the i-th caller
+    llvm::ArrayRef<uint32_t> findCallees(llvm::StringRef callerName) const; // empty if callerName calls nothing
+    llvm::StringRef getName(uint32_t nameIdx) const;
+
+    static bool isBinaryCGFile(std::string filename); // check the magic only
+    static bool convertText(std::string textFilename, std::string binaryFilename, std::ostream &out); // "caller->callee" per line
+
+private:
+    std::unique_ptr<llvm::MemoryBuffer> buffer;
+    const BinaryCGHeader *header;
+    const uint64_t *rowStart;
+    const uint32_t *nameOffsets;
+    const uint32_t *callers;
+    const uint32_t *callees;
+    const char *strTab;
+};
@@ -1,5 +1,6 @@
 #include "llvm/IR/InstIterator.h"
 
+#include "BinaryCG.h"
 #include "CallGraph.h"
 #include "Utils.h"
 
@@ -21,13 +22,13 @@ DSimpleCGSet readDSimpleCGSet(string filename)
     return res;
 }
 
-DSimpleCGMap DSimpleCGSet2DSimpleCGMap(DSimpleCGSet dSimpleCGSet)
+DSimpleCGMap DSimpleCGSet2DSimpleCGMap(const DSimpleCGSet &dSimpleCGSet)
 {
     DSimpleCGMap res;
-    for (auto edge : dSimpleCGSet)
+    for (auto &edge : dSimpleCGSet)
     {
-        string src = edge.first;
-        string dst = edge.second;
+        const string &src = edge.first;
+        const string &dst = edge.second;
 
         // update adj
         if (res.find(src) == res.end())
@@ -39,49 +40,119 @@ DSimpleCGMap DSimpleCGSet2DSimpleCGMap(DSimpleCGSet dSimpleCGSet)
     return res;
 }
 
-CGMap DSimpleCGMap2CGMap(GlobalState &glbState, DSimpleCGMap dSimpleCGMap)
+// a definition of name, without loading its body; null if it is not parsed
+static Function *lookupFuncDef(GlobalState &glbState, StringRef name)
+{
+    ArrayRef<Function *> defs = glbState.getFuncDefs(name);
+    if (defs.empty()) // not parsed
+    {
+        return nullptr;
+    }
+    if (defs.size() != 1)
+    {
+        throw exception();
+    }
+    return defs.front();
+}
+
+IndirectCallGraph::IndirectCallGraph(GlobalState &glbState, const DSimpleCGMap &dSimpleCGMap)
 {
-    CGMap res;
     for (auto &pair : dSimpleCGMap)
     {
-        // find caller function
-        string callerName = pair.first;
-        Function *callerFunc = glbState.getSingleFuncDef(callerName);
+        Function *callerFunc = lookupFuncDef(glbState, pair.first);
         if (!callerFunc)
         {
             continue;
         }
+        for (const string &calleeName : pair.second)
+        {
+            this->addCallee(glbState, callerFunc, calleeName);
+        }
+    }
+}
 
-        for (string calleeName : pair.second)
+IndirectCallGraph::IndirectCallGraph(GlobalState &glbState, const BinaryCG &binaryCG)
+{
+    for (uint32_t i = 0; i < binaryCG.getNumCallers(); ++i)
+    {
+        Function *callerFunc = lookupFuncDef(glbState, binaryCG.getName(binaryCG.getCaller(i)));
+        if (!callerFunc)
         {
-            // find callee function
-            Function *calleeFunc = glbState.getSingleFuncDef(calleeName);
-            if(!calleeFunc)
-            {
-                continue;
-            }
+            continue;
+        }
+        for (uint32_t calleeIdx : binaryCG.getCallees(i))
+        {
+            this->addCallee(glbState, callerFunc, binaryCG.getName(calleeIdx));
+        }
+    }
+}
 
-            // locate callInst within the caller function
-            for (inst_iterator I = inst_begin(callerFunc), E = inst_end(callerFunc); I != E; ++I)
+void IndirectCallGraph::addCallee(GlobalState &glbState, Function *callerFunc, StringRef calleeName)
+{
+    if (Function *calleeFunc = lookupFuncDef(glbState, calleeName))
+    {
+        this->caller2Callees[callerFunc].push_back(calleeFunc);
+    }
+}
+
+bool IndirectCallGraph::getCallees(Function *caller, CallInst *callInst, set<Function *> &callees)
+{
+    lock_guard<mutex> lock(this->mtx);
+    this->indexCaller(caller);
+    auto it = this->cgMap.find(std::make_pair(caller, callInst));
+    if (it == this->cgMap.end())
+    {
+        return false;
+    }
+    callees = it->second;
+    return true;
+}
+
+void IndirectCallGraph::addEdge(Function *caller, CallInst *callInst, Function *callee)
+{
+    lock_guard<mutex> lock(this->mtx);
+    this->cgMap[std::make_pair(caller, callInst)].insert(callee);
+}
+
+void IndirectCallGraph::indexCaller(Function *caller)
+{
+    if (!this->indexedCallers.insert(caller).second)
+    {
+        return;
+    }
+    auto itCallees = this->caller2Callees.find(caller);
+    if (itCallees == this->caller2Callees.end())
+    {
+        return;
+    }
+
+    // indirect callsites bucketed by argument count, joined with the callees in one scan of the caller
+    map<unsigned, vector<CallInst *>> index;
+    for (inst_iterator I = inst_begin(caller), E = inst_end(caller); I != E; ++I)
+    {
+        if (CallInst *CI = dyn_cast<CallInst>(&(*I)))
+        {
+            if (!getCalledFunction(CI))
             {
-                if (CallInst *CI = dyn_cast<CallInst>(&(*I)))
-                {
-                    Function *calledFunc = getCalledFunction(CI);
-                    if (!calledFunc)
-                    {
-                        if (CI->arg_size() == calleeFunc->arg_size()) // TODO: further check function signature
-                        {
-                            res[std::pair<Function *, CallInst *>(callerFunc, CI)].insert(calleeFunc);
-                        }
-                    }
-                }
+                index[CI->arg_size()].push_back(CI);
             }
         }
     }
-    return res;
+    for (Function *calleeFunc : itCallees->second)
+    {
+        auto it = index.find(calleeFunc->arg_size()); // TODO: further check function signature
+        if (it == index.end())
+        {
+            continue;
+        }
+        for (CallInst *CI : it->second)
+        {
+            this->cgMap[std::make_pair(caller, CI)].insert(calleeFunc);
+        }
+    }
 }
 
-Context callTrace2Context(GlobalState &glbState, vector<CallTraceItem> callTrace, CGMap &cgMap)
+Context callTrace2Context(GlobalState &glbState, vector<CallTraceItem> callTrace, IndirectCallGraph &callGraph)
 {
     assert(!callTrace.empty());
     Function *entry = glbState.getSingleFuncDef(callTrace.front().func);
@@ -91,7 +162,7 @@ Context callTrace2Context(GlobalState &glbState, vector<CallTraceItem> callTrace
     Function *currFunc = entry;
     for (uint32_t i = 0; i < callTrace.size() - 1; ++i)
     {
-        std::vector<Instruction *> insts = getAllInstsAtSrcLine(currFunc, callTrace[i].file, callTrace[i].line);
+        ArrayRef<Instruction *> insts = glbState.getInstsAtSrcLine(currFunc, callTrace[i].file, callTrace[i].line);
         for (Instruction *inst : insts)
         {
             if (CallInst *CI = dyn_cast<CallInst>(inst))
@@ -120,7 +191,7 @@ Context callTrace2Context(GlobalState &glbState, vector<CallTraceItem> callTrace
                     if (CI->arg_size() == expectedFunc->arg_size()) // TODO: further check function signature
                     {
                         res = res.add(CI, expectedFunc);
-                        cgMap[std::make_pair(currFunc, CI)].insert(expectedFunc); // update indirect call graph
+                        callGraph.addEdge(currFunc, CI, expectedFunc); // update indirect call graph
                         currFunc = expectedFunc;
                         break; // pick the first match
                     }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Module.h"
 
@@ -8,6 +10,7 @@
 #include "InstLoc.h"
 
 #include <map>
+#include <mutex>
 #include <set>
 #include <string>
 #include <vector>
@@ -20,11 +23,32 @@ typedef std::set<DSimpleCGEdge> DSimpleCGSet;
 // Context-insensitive call graph
 typedef std::pair<llvm::Function *, llvm::CallInst *> Caller;
 typedef std::map<Caller, std::set<llvm::Function *>> CGMap;
-typedef std::pair<Caller, llvm::Function *> CGEdge;
-typedef std::set<CGEdge> CGSet;
+
+class BinaryCG;
 
 DSimpleCGSet readDSimpleCGSet(std::string filename);
-DSimpleCGMap DSimpleCGSet2DSimpleCGMap(DSimpleCGSet dSimpleCGSet);
-CGMap DSimpleCGMap2CGMap(GlobalState &glbState, DSimpleCGMap dSimpleCGMap);
+DSimpleCGMap DSimpleCGSet2DSimpleCGMap(const DSimpleCGSet &dSimpleCGSet);
+
+// The indirect call graph from the cg file. Names are resolved to definitions without loading their bodies, and the
+// indirect callsites of a caller are located when the analysis first reaches it, whose body is loaded by then
+class IndirectCallGraph
+{
+public:
+    IndirectCallGraph(GlobalState &glbState, const DSimpleCGMap &dSimpleCGMap);
+    IndirectCallGraph(GlobalState &glbState, const BinaryCG &binaryCG); // same as above, read from the mapped file
+
+    // callees of an indirect callsite in the loaded body of caller; false if the call graph has none. Thread-safe
+    bool getCallees(llvm::Function *caller, llvm::CallInst *callInst, std::set<llvm::Function *> &callees);
+    void addEdge(llvm::Function *caller, llvm::CallInst *callInst, llvm::Function *callee); // e.g. from a call trace
+
+private:
+    llvm::DenseMap<llvm::Function *, std::vector<llvm::Function *>> caller2Callees; // callees may be unloaded
+    llvm::DenseSet<llvm::Function *> indexedCallers; // whose callsites are in cgMap
+    CGMap cgMap;
+    std::mutex mtx; // entries are analyzed in parallel
+
+    void addCallee(GlobalState &glbState, llvm::Function *callerFunc, llvm::StringRef calleeName); // called in constructors
+    void indexCaller(llvm::Function *caller); // with mtx held
+};
 
-Context callTrace2Context(GlobalState &glbState, std::vector<CallTraceItem> callTrace, CGMap &cgMap);
+Context callTrace2Context(GlobalState &glbState, std::vector<CallTraceItem> callTrace, IndirectCallGraph &callGraph);
@@ -36,7 +36,13 @@ void parseConfigFile(
     vector<string> &inputFilenames,
     uint32_t &maxCallDepth,
     string &callGraph,
-    bool &doPrint)
+    bool &doPrint,
+    uint32_t &numThreads,
+    bool &lazyLoad,
+    string &symbolIndex,
+    bool &resolveIndirectCalls,
+    bool &summarizeCalls,
+    DummyGranularity &dummyGranularity)
 {
     ifstream configFile(filename);
     assert(configFile.is_open());
@@ -103,4 +109,77 @@ void parseConfigFile(
     {
         doPrint = false;
     }
+
+    // number of worker threads, 0 means one per hardware thread
+    if (j.contains("numThreads"))
+    {
+        numThreads = j["numThreads"];
+    }
+    else
+    {
+        numThreads = 0;
+    }
+
+    // whether to materialize function bodies on first use instead of at parse time
+    if (j.contains("lazyLoad"))
+    {
+        lazyLoad = j["lazyLoad"];
+    }
+    else
+    {
+        lazyLoad = false;
+    }
+
+    // symbol index file used to parse only the files reachable from the entries
+    if (j.contains("symbolIndex"))
+    {
+        symbolIndex = j["symbolIndex"];
+    }
+    else
+    {
+        symbolIndex = "";
+    }
+
+    // whether to resolve indirect calls missing in the call graph by function types
+    if (j.contains("resolveIndirectCalls"))
+    {
+        resolveIndirectCalls = j["resolveIndirectCalls"];
+    }
+    else
+    {
+        resolveIndirectCalls = false;
+    }
+
+    // whether to reuse the analysis of a callee for calls with the same points-to of arguments
+    if (j.contains("summarizeCalls"))
+    {
+        summarizeCalls = j["summarizeCalls"];
+    }
+    else
+    {
+        summarizeCalls = false;
+    }
+
+    // how dummy objects are shared: "context", "function" or "type"
+    if (j.contains("dummyGranularity"))
+    {
+        string granularity = j["dummyGranularity"];
+        if (granularity == "function")
+        {
+            dummyGranularity = perFunctionValue;
+        }
+        else if (granularity == "type")
+        {
+            dummyGranularity = perType;
+        }
+        else
+        {
+            assert(granularity == "context");
+            dummyGranularity = perContextValue;
+        }
+    }
+    else
+    {
+        dummyGranularity = perContextValue;
+    }
 }
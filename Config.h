@@ -3,6 +3,14 @@
 #include <string>
 #include <vector>
 
+// How dummy objects, the pointees made up for pointers without known pointees, are shared
+enum DummyGranularity
+{
+    perContextValue, // one per pointer in each context
+    perFunctionValue, // one per pointer, across contexts
+    perType, // one per pointed-to struct type; one per pointer for other types
+};
+
 class CallTraceItem
 {
 public:
@@ -24,4 +32,4 @@ public:
 };
 
 std::vector<std::string> parseInput(std::string input);
-void parseConfigFile(std::string filename, std::vector<std::string> &entryFunctionNames, std::vector<InitMemErr> &initMemErrs, std::vector<std::string> &inputFilenames, uint32_t &maxCallDepth, std::string &callGraph, bool &doPrint);
+void parseConfigFile(std::string filename, std::vector<std::string> &entryFunctionNames, std::vector<InitMemErr> &initMemErrs, std::vector<std::string> &inputFilenames, uint32_t &maxCallDepth, std::string &callGraph, bool &doPrint, uint32_t &numThreads, bool &lazyLoad, std::string &symbolIndex, bool &resolveIndirectCalls, bool &summarizeCalls, DummyGranularity &dummyGranularity);
@@ -5,246 +5,416 @@
 
 #include <boost/range.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <iostream>
+#include <thread>
 
 using namespace llvm;
 using namespace std;
 
-ValNode::ValNode(NodeId id, Context ctx, Value *val) : id(id), ctx(ctx), val(val)
+DefUse::DefUse(NodeId srcId, NodeId dstId) : srcId(srcId), dstId(dstId)
 {
 }
 
-LoadNode::LoadNode(NodeId id, Context ctx, LoadInst *loadInst) : id(id), ctx(ctx), loadInst(loadInst)
+void CSRMap::build(uint64_t numNodes, ArrayRef<NodeId> keys, ArrayRef<uint64_t> values)
 {
+    // counting sort on the key
+    this->offsets.assign(numNodes + 1, 0);
+    for (NodeId key : keys)
+    {
+        this->offsets[key + 1]++;
+    }
+    for (NodeId nodeId = 0; nodeId < numNodes; ++nodeId)
+    {
+        this->offsets[nodeId + 1] += this->offsets[nodeId];
+    }
+    this->items.resize(values.size());
+    vector<uint64_t> next(this->offsets.begin(), this->offsets.end() - 1);
+    for (uint64_t i = 0; i < keys.size(); ++i)
+    {
+        this->items[next[keys[i]]++] = values[i];
+    }
 }
 
-StoreNode::StoreNode(NodeId id, Context ctx, StoreInst *storeInst) : id(id), ctx(ctx), storeInst(storeInst)
+ArrayRef<uint64_t> CSRMap::get(NodeId nodeId) const
 {
+    return ArrayRef<uint64_t>(this->items.data() + this->offsets[nodeId], this->items.data() + this->offsets[nodeId + 1]);
 }
 
-MemCpyNode::MemCpyNode(NodeId id, Context ctx, llvm::Instruction *memCpyInst) : id(id), ctx(ctx), memCpyInst(memCpyInst)
+void ObjIndex::build(ArrayRef<ObjId> column)
 {
+    vector<pair<ObjId, RowId>> entries;
+    entries.reserve(column.size());
+    for (RowId row = 0; row < column.size(); ++row)
+    {
+        entries.push_back(std::make_pair(column[row], row));
+    }
+    std::sort(entries.begin(), entries.end());
+    this->keys.resize(entries.size());
+    this->rows.resize(entries.size());
+    for (uint64_t i = 0; i < entries.size(); ++i)
+    {
+        this->keys[i] = entries[i].first;
+        this->rows[i] = entries[i].second;
+    }
 }
 
-CopyOutNode::CopyOutNode(NodeId id, Context ctx, llvm::CallInst *callInst) : id(id), ctx(ctx), callInst(callInst)
+ArrayRef<RowId> ObjIndex::get(ObjId objId) const
 {
+    auto range = std::equal_range(this->keys.begin(), this->keys.end(), objId);
+    return ArrayRef<RowId>(this->rows.data() + (range.first - this->keys.begin()), this->rows.data() + (range.second - this->keys.begin()));
 }
 
-ValueOutNode::ValueOutNode(NodeId id, Context ctx, llvm::CallInst *callInst) : id(id), ctx(ctx), callInst(callInst)
+// an index on a node column
+static CSRMap indexBy(uint64_t numNodes, const vector<NodeId> &column)
 {
+    vector<RowId> rows(column.size());
+    for (RowId row = 0; row < rows.size(); ++row)
+    {
+        rows[row] = row;
+    }
+    CSRMap index;
+    index.build(numNodes, column, rows);
+    return index;
 }
 
-DefUse::DefUse(NodeId srcId, NodeId dstId) : srcId(srcId), dstId(dstId)
+// the rows of a table in the order of a node column, and in row order for equal nodes
+static vector<RowId> getOrderBy(uint64_t numNodes, const vector<NodeId> &column)
 {
+    return indexBy(numNodes, column).items;
 }
 
-LoadRelation::LoadRelation(NodeId loadInstId, NodeId srcId, NodeId valId, uint64_t loadSize) : loadInstId(loadInstId), srcId(srcId), valId(valId), loadSize(loadSize)
+// permute a column into order
+template <typename T>
+static void reorder(vector<T> &column, const vector<RowId> &order)
 {
+    vector<T> res;
+    res.reserve(order.size());
+    for (RowId row : order)
+    {
+        res.push_back(column[row]);
+    }
+    column.swap(res);
 }
 
-LoadPtrPto::LoadPtrPto(NodeId srcId, ObjId objId, offset_t offset) : srcId(srcId), objId(objId), offset(offset)
+bool LoadRelations::add(NodeId loadInstId, NodeId srcId, NodeId valId, uint64_t loadSize)
 {
+    if (!this->loadInsts.insert(loadInstId).second)
+    {
+        return false;
+    }
+    this->loadInstIds.push_back(loadInstId);
+    this->srcIds.push_back(srcId);
+    this->valIds.push_back(valId);
+    this->loadSizes.push_back(loadSize);
+    return true;
 }
 
-StoreRelation::StoreRelation(NodeId storeInstId, NodeId valId, NodeId dstId, uint64_t storeSize) : storeInstId(storeInstId), valId(valId), dstId(dstId), storeSize(storeSize)
+RowId LoadRelations::size() const
 {
+    return this->loadInstIds.size();
 }
 
-StorePtrPto::StorePtrPto(NodeId dstId, ObjId objId, offset_t offset) : dstId(dstId), objId(objId), offset(offset)
+void LoadRelations::freeze(uint64_t numNodes)
 {
+    vector<RowId> order = getOrderBy(numNodes, this->loadInstIds);
+    reorder(this->loadInstIds, order);
+    reorder(this->srcIds, order);
+    reorder(this->valIds, order);
+    reorder(this->loadSizes, order);
+    this->bySrcId = indexBy(numNodes, this->srcIds);
+    this->loadInsts = DenseSet<NodeId>();
 }
 
-MemCpyRelation::MemCpyRelation(NodeId memCpyInstId, NodeId srcId, NodeId dstId, NodeId nId) : memCpyInstId(memCpyInstId), srcId(srcId), dstId(dstId), nId(nId)
+bool LoadPtrPtos::add(NodeId srcId, ObjId objId, offset_t offset)
 {
+    if (!this->rows.insert(std::make_tuple(srcId, objId, offset)).second)
+    {
+        return false;
+    }
+    this->srcIds.push_back(srcId);
+    this->objIds.push_back(objId);
+    this->offsets.push_back(offset);
+    return true;
 }
 
-CopyOutFromRel::CopyOutFromRel(NodeId copyOutInstId, NodeId fromId) : copyOutInstId(copyOutInstId), fromId(fromId)
+RowId LoadPtrPtos::size() const
 {
+    return this->srcIds.size();
 }
 
-CopyOutNRel::CopyOutNRel(NodeId copyOutInstId, NodeId nId) : copyOutInstId(copyOutInstId), nId(nId)
+void LoadPtrPtos::freeze(uint64_t numNodes)
 {
+    vector<RowId> order = getOrderBy(numNodes, this->srcIds);
+    reorder(this->srcIds, order);
+    reorder(this->objIds, order);
+    reorder(this->offsets, order);
+    this->bySrcId = indexBy(numNodes, this->srcIds);
+    this->byObjId.build(this->objIds);
+    this->rows = DenseSet<std::tuple<NodeId, ObjId, offset_t>>();
 }
 
-DDG::DDG() : currNodeId(0)
+bool StoreRelations::add(NodeId storeInstId, NodeId valId, NodeId dstId, uint64_t storeSize)
 {
+    if (!this->storeInsts.insert(storeInstId).second)
+    {
+        return false;
+    }
+    this->storeInstIds.push_back(storeInstId);
+    this->valIds.push_back(valId);
+    this->dstIds.push_back(dstId);
+    this->storeSizes.push_back(storeSize);
+    return true;
 }
 
-NodeId DDG::getOrCreateValNode(Context context, Value *val)
+RowId StoreRelations::size() const
 {
-    auto &ctxValView = this->valNodeSet.get<1>();
-    auto it = ctxValView.find(boost::make_tuple(context, val));
-    if (it != ctxValView.end()) // get
-    {
-        return it->id;
-    }
-    else // create
+    return this->storeInstIds.size();
+}
+
+void StoreRelations::freeze(uint64_t numNodes)
+{
+    vector<RowId> order = getOrderBy(numNodes, this->storeInstIds);
+    reorder(this->storeInstIds, order);
+    reorder(this->valIds, order);
+    reorder(this->dstIds, order);
+    reorder(this->storeSizes, order);
+    this->byDstId = indexBy(numNodes, this->dstIds);
+    this->storeInsts = DenseSet<NodeId>();
+}
+
+bool StorePtrPtos::add(NodeId dstId, ObjId objId, offset_t offset)
+{
+    if (!this->rows.insert(std::make_tuple(dstId, objId, offset)).second)
     {
-        NodeId id = this->genNodeId();
-        this->nodeKindMap[id] = NodeKind::value;
-        this->valNodeSet.insert(ValNode(id, context, val));
-        return id;
+        return false;
     }
+    this->dstIds.push_back(dstId);
+    this->objIds.push_back(objId);
+    this->offsets.push_back(offset);
+    return true;
 }
 
-NodeId DDG::getOrCreateLoadNode(Context context, LoadInst *loadInst)
+RowId StorePtrPtos::size() const
 {
-    auto &ctxInstView = this->loadNodeSet.get<1>();
-    auto it = ctxInstView.find(boost::make_tuple(context, loadInst));
-    if (it != ctxInstView.end()) // get
-    {
-        return it->id;
+    return this->dstIds.size();
+}
+
+void StorePtrPtos::freeze(uint64_t numNodes)
+{
+    vector<RowId> order = getOrderBy(numNodes, this->dstIds);
+    reorder(this->dstIds, order);
+    reorder(this->objIds, order);
+    reorder(this->offsets, order);
+    this->byDstId = indexBy(numNodes, this->dstIds);
+    this->byObjId.build(this->objIds);
+    this->rows = DenseSet<std::tuple<NodeId, ObjId, offset_t>>();
+}
+
+void MemCpyRelations::add(NodeId memCpyInstId, NodeId srcId, NodeId dstId, NodeId nId)
+{
+    this->memCpyInstIds.push_back(memCpyInstId);
+    this->srcIds.push_back(srcId);
+    this->dstIds.push_back(dstId);
+    this->nIds.push_back(nId);
+}
+
+RowId MemCpyRelations::size() const
+{
+    return this->memCpyInstIds.size();
+}
+
+void MemCpyRelations::freeze(uint64_t numNodes)
+{
+    vector<RowId> order = getOrderBy(numNodes, this->srcIds);
+    reorder(this->memCpyInstIds, order);
+    reorder(this->srcIds, order);
+    reorder(this->dstIds, order);
+    reorder(this->nIds, order);
+    this->bySrcId = indexBy(numNodes, this->srcIds);
+    this->byDstId = indexBy(numNodes, this->dstIds);
+    this->byNId = indexBy(numNodes, this->nIds);
+}
+
+void CopyOutFromRels::add(NodeId copyOutInstId, NodeId fromId)
+{
+    this->copyOutInstIds.push_back(copyOutInstId);
+    this->fromIds.push_back(fromId);
+}
+
+RowId CopyOutFromRels::size() const
+{
+    return this->copyOutInstIds.size();
+}
+
+void CopyOutFromRels::freeze(uint64_t numNodes)
+{
+    vector<RowId> order = getOrderBy(numNodes, this->copyOutInstIds);
+    reorder(this->copyOutInstIds, order);
+    reorder(this->fromIds, order);
+    this->byFromId = indexBy(numNodes, this->fromIds);
+}
+
+void CopyOutNRels::add(NodeId copyOutInstId, NodeId nId)
+{
+    this->copyOutInstIds.push_back(copyOutInstId);
+    this->nIds.push_back(nId);
+}
+
+RowId CopyOutNRels::size() const
+{
+    return this->copyOutInstIds.size();
+}
+
+void CopyOutNRels::freeze(uint64_t numNodes)
+{
+    vector<RowId> order = getOrderBy(numNodes, this->copyOutInstIds);
+    reorder(this->copyOutInstIds, order);
+    reorder(this->nIds, order);
+    this->byCopyOutInstId = indexBy(numNodes, this->copyOutInstIds);
+    this->byNId = indexBy(numNodes, this->nIds);
+}
+
+MemAccess::MemAccess(offset_t start, offset_t end, NodeId nodeId) : start(start), end(end), nodeId(nodeId)
+{
+}
+
+bool MemAccess::operator<(const MemAccess &rhs) const
+{
+    return std::tie(this->start, this->end, this->nodeId) < std::tie(rhs.start, rhs.end, rhs.nodeId);
+}
+
+bool MemAccess::operator==(const MemAccess &rhs) const
+{
+    return this->start == rhs.start && this->end == rhs.end && this->nodeId == rhs.nodeId;
+}
+
+void ObjAccesses::join(vector<pair<NodeId, NodeId>> &edges)
+{
+    std::sort(this->writes.begin(), this->writes.end());
+    this->writes.erase(std::unique(this->writes.begin(), this->writes.end()), this->writes.end());
+    std::sort(this->reads.begin(), this->reads.end());
+    this->reads.erase(std::unique(this->reads.begin(), this->reads.end()), this->reads.end());
+
+    // sweep the accesses by start. An access stays active until a start at or after its end, as getExtentEnd()
+    // extends an unknown length, and is checked against each access of the other kind that starts meanwhile
+    vector<MemAccess> activeWrites;
+    vector<MemAccess> activeReads;
+    uint64_t w = 0;
+    uint64_t r = 0;
+    while (w < this->writes.size() || r < this->reads.size())
+    {
+        bool isWrite = r == this->reads.size() || (w < this->writes.size() && this->writes[w].start <= this->reads[r].start);
+        const MemAccess &curr = isWrite ? this->writes[w++] : this->reads[r++];
+        vector<MemAccess> &others = isWrite ? activeReads : activeWrites;
+        for (uint64_t i = 0; i < others.size();)
+        {
+            offset_t otherEnd = getExtentEnd(others[i].start, others[i].end);
+            if (otherEnd <= curr.start)
+            {
+                others[i] = others.back();
+                others.pop_back();
+                continue;
+            }
+            if (overlap(curr.start, curr.end, others[i].start, others[i].end))
+            {
+                edges.push_back(isWrite ? std::make_pair(curr.nodeId, others[i].nodeId) : std::make_pair(others[i].nodeId, curr.nodeId));
+            }
+            ++i;
+        }
+        (isWrite ? activeWrites : activeReads).push_back(curr);
     }
-    else // create
+
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+}
+
+DDG::DDG(const ObjectManager &objMgr) : objMgr(objMgr), relationsFrozen(false), frozen(false), numSearches(0)
+{
+}
+
+NodeId DDG::getOrCreateNode(NodeKind kind, Context context, Value *val)
+{
+    assert(!this->frozen);
+    auto res = this->key2Node[kind].insert(std::make_pair(NodeKey(context.id, val), this->nodeKinds.size()));
+    if (res.second) // create
     {
-        NodeId id = this->genNodeId();
-        this->nodeKindMap[id] = NodeKind::load;
-        this->loadNodeSet.insert(LoadNode(id, context, loadInst));
-        return id;
+        this->nodeKinds.push_back(kind);
+        this->nodeCtxs.push_back(context.id);
+        this->nodeVals.push_back(val);
     }
+    return res.first->second;
+}
+
+NodeId DDG::getOrCreateValNode(Context context, Value *val)
+{
+    return this->getOrCreateNode(NodeKind::value, context, val);
+}
+
+NodeId DDG::getOrCreateLoadNode(Context context, LoadInst *loadInst)
+{
+    return this->getOrCreateNode(NodeKind::load, context, loadInst);
 }
 
 NodeId DDG::getOrCreateStoreNode(Context context, StoreInst *storeInst)
 {
-    auto &ctxInstView = this->storeNodeSet.get<1>();
-    auto it = ctxInstView.find(boost::make_tuple(context, storeInst));
-    if (it != ctxInstView.end()) // get
-    {
-        return it->id;
-    }
-    else // create
-    {
-        NodeId id = this->genNodeId();
-        this->nodeKindMap[id] = NodeKind::store;
-        this->storeNodeSet.insert(StoreNode(id, context, storeInst));
-        return id;
-    }
+    return this->getOrCreateNode(NodeKind::store, context, storeInst);
 }
 
 NodeId DDG::getOrCreateMemCpyNode(Context context, llvm::Instruction *memCpyInst)
 {
-    auto &ctxInstView = this->memCpyNodeSet.get<1>();
-    auto it = ctxInstView.find(boost::make_tuple(context, memCpyInst));
-    if (it != ctxInstView.end()) // get
-    {
-        return it->id;
-    }
-    else // create
-    {
-        NodeId id = this->genNodeId();
-        this->nodeKindMap[id] = NodeKind::mcpy;
-        this->memCpyNodeSet.insert(MemCpyNode(id, context, memCpyInst));
-        return id;
-    }
+    return this->getOrCreateNode(NodeKind::mcpy, context, memCpyInst);
 }
 
 NodeId DDG::getOrCreateCopyOutNode(Context context, CallInst *callInst)
 {
-    auto &ctxInstView = this->copyOutNodeSet.get<1>();
-    auto it = ctxInstView.find(boost::make_tuple(context, callInst));
-    if (it != ctxInstView.end()) // get
-    {
-        return it->id;
-    }
-    else // create
-    {
-        NodeId id = this->genNodeId();
-        this->nodeKindMap[id] = NodeKind::copyout;
-        this->copyOutNodeSet.insert(CopyOutNode(id, context, callInst));
-        return id;
-    }
+    return this->getOrCreateNode(NodeKind::copyout, context, callInst);
 }
 
 NodeId DDG::getOrCreateValOutNode(Context context, llvm::CallInst *callInst)
 {
-    auto &ctxInstView = this->valueOutNodeSet.get<1>();
-    auto it = ctxInstView.find(boost::make_tuple(context, callInst));
-    if (it != ctxInstView.end()) // get
-    {
-        return it->id;
-    }
-    else // create
+    return this->getOrCreateNode(NodeKind::valout, context, callInst);
+}
+
+NodeId DDG::findNode(NodeKind kind, Context context, Value *val) const
+{
+    auto it = this->key2Node[kind].find(NodeKey(context.id, val));
+    if (it == this->key2Node[kind].end())
     {
-        NodeId id = this->genNodeId();
-        this->nodeKindMap[id] = NodeKind::valout;
-        this->valueOutNodeSet.insert(ValueOutNode(id, context, callInst));
-        return id;
+        return noNode;
     }
+    return it->second;
 }
 
-inline NodeKind DDG::getNodeKind(NodeId nodeId) const
+NodeId DDG::findLoadNode(Context context, LoadInst *loadInst) const
 {
-    return this->nodeKindMap.at(nodeId);
+    return this->findNode(NodeKind::load, context, loadInst);
+}
+
+NodeId DDG::findMemCpyNode(Context context, llvm::Instruction *memCpyInst) const
+{
+    return this->findNode(NodeKind::mcpy, context, memCpyInst);
+}
+
+NodeKind DDG::getNodeKind(NodeId nodeId) const
+{
+    return this->nodeKinds[nodeId];
 }
 
 string DDG::nodeId2String(NodeId nodeId, bool hasSrcLoc)
 {
     string fn; // filename
     uint32_t ln; // line number
-    string ctxStr;
-    string name;
-    switch (this->getNodeKind(nodeId))
-    {
-    case NodeKind::value:
+    Value *val = this->nodeVals[nodeId];
+    if (Instruction *I = dyn_cast<Instruction>(val))
     {
-        auto itVal = this->valNodeSet.find(nodeId);
-        Value *val = itVal->val;
-        if (Instruction *I = dyn_cast<Instruction>(val))
-        {
-            std::tie(fn, ln) = getInstFileAndLine(I);
-        }
-        ctxStr = itVal->ctx.toString();
-        name = getName(val);
-        break;
-    }
-    case NodeKind::load:
-    {
-        auto itLoad = this->loadNodeSet.find(nodeId);
-        LoadInst *loadInst = itLoad->loadInst;
-        std::tie(fn, ln) = getInstFileAndLine(loadInst);
-        ctxStr = itLoad->ctx.toString();
-        name = getName(loadInst, false);
-        break;
-    }
-    case NodeKind::store:
-    {
-        auto itStore = this->storeNodeSet.find(nodeId);
-        StoreInst *storeInst = itStore->storeInst;
-        std::tie(fn, ln) = getInstFileAndLine(storeInst);
-        ctxStr = itStore->ctx.toString();
-        name = getName(storeInst, false);
-        break;
-    }
-    case NodeKind::mcpy:
-    {
-        auto itMemCpy = this->memCpyNodeSet.find(nodeId);
-        Instruction *memCpyInst = itMemCpy->memCpyInst;
-        std::tie(fn, ln) = getInstFileAndLine(memCpyInst);
-        ctxStr = itMemCpy->ctx.toString();
-        name = getName(memCpyInst, false);
-        break;
-    }
-    case NodeKind::copyout:
-    {
-        auto itCopyOut = this->copyOutNodeSet.find(nodeId);
-        CallInst *callInst = itCopyOut->callInst;
-        std::tie(fn, ln) = getInstFileAndLine(callInst);
-        ctxStr = itCopyOut->ctx.toString();
-        name = getName(callInst, false);
-        break;
-    }
-    case NodeKind::valout:
-    {
-        auto itValueOut = this->valueOutNodeSet.find(nodeId);
-        CallInst *callInst = itValueOut->callInst;
-        std::tie(fn, ln) = getInstFileAndLine(callInst);
-        ctxStr = itValueOut->ctx.toString();
-        name = getName(callInst, false);
-        break;
-    }
-    default:
-        return "error";
+        std::tie(fn, ln) = getInstFileAndLine(I);
     }
+    string ctxStr = Context(this->nodeCtxs[nodeId]).toString();
+    string name = getName(val, this->getNodeKind(nodeId) == NodeKind::value); // an instruction node is named by the whole instruction
+
     string res;
     if (hasSrcLoc && !fn.empty())
     {
@@ -257,17 +427,15 @@ string DDG::nodeId2String(NodeId nodeId, bool hasSrcLoc)
 
 void DDG::addDefUseEdge(NodeId src, NodeId dst)
 {
-    // TODO: deduplication
-    this->defUseSet.insert(DefUse(src, dst)); // TODO: redundant
+    this->defUseSet.insert(DefUse(src, dst));
 
     // info edge
     boost::add_edge(src, dst, this->graph);
 }
 
-void DDG::addLoadRelation(NodeId loadInstId, NodeId srcId, NodeId valId, set<ObjLoc> srcPtees, uint64_t loadSize)
+void DDG::addLoadRelation(NodeId loadInstId, NodeId srcId, NodeId valId, ArrayRef<ObjLoc> srcPtees, uint64_t loadSize)
 {
-    // TODO: deduplication
-    this->loadRelations.insert(LoadRelation(loadInstId, srcId, valId, loadSize)); // TODO: redundant
+    this->loadRelations.add(loadInstId, srcId, valId, loadSize);
 
     // info edge
     boost::add_edge(loadInstId, valId, this->graph);
@@ -275,28 +443,13 @@ void DDG::addLoadRelation(NodeId loadInstId, NodeId srcId, NodeId valId, set<Obj
     // alias info
     for (ObjLoc srcPtee : srcPtees)
     {
-        this->loadPtrPtos.insert(LoadPtrPto(srcId, srcPtee.objId, srcPtee.offset));
-    }
-
-    // connect store-like nodes to load
-    for (ObjLoc srcPtee : srcPtees)
-    {
-        ObjId objId = srcPtee.objId;
-        offset_t start = srcPtee.offset;
-        offset_t end = start + loadSize;
-
-        set<NodeId> storeLikeNodes = this->getStoreLikeNodesOnRange(objId, start, end);
-        for (NodeId storeLikeNode : storeLikeNodes)
-        {
-            boost::add_edge(storeLikeNode, loadInstId, this->graph);
-        }
+        this->loadPtrPtos.add(srcId, srcPtee.objId, srcPtee.offset);
     }
 }
 
-void DDG::addStoreRelation(NodeId storeInstId, NodeId valId, NodeId dstId, set<ObjLoc> dstPtees, uint64_t storeSize)
+void DDG::addStoreRelation(NodeId storeInstId, NodeId valId, NodeId dstId, ArrayRef<ObjLoc> dstPtees, uint64_t storeSize)
 {
-    // TODO: deduplication
-    this->storeRelations.insert(StoreRelation(storeInstId, valId, dstId, storeSize)); // TODO: redundant
+    this->storeRelations.add(storeInstId, valId, dstId, storeSize);
 
     // info edge
     boost::add_edge(valId, storeInstId, this->graph);
@@ -304,179 +457,223 @@ void DDG::addStoreRelation(NodeId storeInstId, NodeId valId, NodeId dstId, set<O
     // alias info
     for (ObjLoc dstPtee : dstPtees)
     {
-        this->storePtrPtos.insert(StorePtrPto(dstId, dstPtee.objId, dstPtee.offset));
+        this->storePtrPtos.add(dstId, dstPtee.objId, dstPtee.offset);
     }
 }
 
-void DDG::addMemCpy(NodeId memCpyInstId, NodeId srcId, NodeId dstId, NodeId nId, std::set<ObjLoc> srcPtees, std::set<ObjLoc> dstPtees)
+void DDG::addMemCpy(NodeId memCpyInstId, NodeId srcId, NodeId dstId, NodeId nId, ArrayRef<ObjLoc> srcPtees, ArrayRef<ObjLoc> dstPtees)
 {
-    this->memCpyRelations.insert(MemCpyRelation(memCpyInstId, srcId, dstId, nId));
+    this->memCpyRelations.add(memCpyInstId, srcId, dstId, nId);
 
     // alias info
     for (ObjLoc srcPtee : srcPtees)
     {
-        this->loadPtrPtos.insert(LoadPtrPto(srcId, srcPtee.objId, srcPtee.offset));
+        this->loadPtrPtos.add(srcId, srcPtee.objId, srcPtee.offset);
     }
     for (ObjLoc dstPtee : dstPtees)
     {
-        this->storePtrPtos.insert(StorePtrPto(dstId, dstPtee.objId, dstPtee.offset));
+        this->storePtrPtos.add(dstId, dstPtee.objId, dstPtee.offset);
     }
+}
 
-    // connect store-like nodes to memCpy
-    for (ObjLoc srcPtee : srcPtees)
+void DDG::addCopyOutRelation(NodeId copyOutInstId, NodeId fromId, NodeId nId, ArrayRef<ObjLoc> fromPtees)
+{
+    this->copyOutFromRels.add(copyOutInstId, fromId);
+    if (nId != -1)
     {
-        ObjId objId = srcPtee.objId;
-        offset_t start = srcPtee.offset;
-        offset_t end;
-        auto it = this->valNodeSet.find(nId);
-        Value *n = it->val;
-        if (ConstantInt *constantInt = dyn_cast<ConstantInt>(n))
-        {
-            int64_t copySize = constantInt->getSExtValue();
-            end = start + copySize;
-        }
-        else
+        this->copyOutNRels.add(copyOutInstId, nId);
+    }
+
+    // alias info
+    for (ObjLoc fromPtee : fromPtees)
+    {
+        this->loadPtrPtos.add(fromId, fromPtee.objId, fromPtee.offset);
+    }
+}
+
+set<NodeId> DDG::getStoreLikeNodesOnObj(ObjId objId)
+{
+    assert(this->relationsFrozen);
+    set<NodeId> res;
+    for (RowId ptoRow : this->storePtrPtos.byObjId.get(objId))
+    {
+        NodeId dstId = this->storePtrPtos.dstIds[ptoRow];
+
+        // store nodes
+        for (RowId row : this->storeRelations.byDstId.get(dstId))
         {
-            end = -1;
+            res.insert(this->storeRelations.storeInstIds[row]);
         }
 
-        set<NodeId> storeLikeNodes = this->getStoreLikeNodesOnRange(objId, start, end);
-        for (NodeId storeLikeNode : storeLikeNodes)
+        // memCpy nodes
+        for (RowId row : this->memCpyRelations.byDstId.get(dstId))
         {
-            boost::add_edge(storeLikeNode, memCpyInstId, this->graph);
+            res.insert(this->memCpyRelations.memCpyInstIds[row]);
         }
     }
+    return res;
 }
 
-void DDG::addCopyOutRelation(NodeId copyOutInstId, NodeId fromId, NodeId nId, set<ObjLoc> fromPtees)
+offset_t DDG::getEnd(ObjId objId, offset_t start, NodeId nId)
 {
-    // TODO: deduplication
-    this->copyOutFromRels.insert(CopyOutFromRel(copyOutInstId, fromId));
-    if (nId != -1)
+    Value *n = this->nodeVals[nId];
+    if (ConstantInt *constantInt = dyn_cast<ConstantInt>(n))
     {
-        this->copyOutNRels.insert(CopyOutNRel(copyOutInstId, nId));
+        return start + constantInt->getSExtValue();
     }
+    return this->getEndInObj(objId, start, -1);
+}
 
-    // alias info
-    for (ObjLoc fromPtee : fromPtees)
+offset_t DDG::getEndInObj(ObjId objId, offset_t start, offset_t end)
+{
+    if (end != -1)
     {
-        this->loadPtrPtos.insert(LoadPtrPto(fromId, fromPtee.objId, fromPtee.offset));
+        return end;
     }
 
-    // connect store-like nodes to copyOut
-    int64_t n; // copy out length
-    if (nId != -1)
+    // an unknown length reaches the end of the object, if its size is known and the access starts inside it
+    offset_t size = this->objMgr.getObjectSize(objId);
+    if (size == -1 || start >= size)
     {
-        Value *nVal = this->valNodeSet.find(nId)->val;
+        return -1;
+    }
+    return size;
+}
+
+offset_t DDG::getCopyOutEnd(NodeId copyOutInstId, ObjId objId, offset_t start)
+{
+    int64_t n = -1; // copy out length
+    ArrayRef<RowId> nRows = this->copyOutNRels.byCopyOutInstId.get(copyOutInstId);
+    if (!nRows.empty())
+    {
+        Value *nVal = this->nodeVals[this->copyOutNRels.nIds[nRows.front()]];
         if (ConstantInt *constantInt = dyn_cast<ConstantInt>(nVal))
         {
             n = constantInt->getSExtValue();
         }
-        else
-        {
-            n = -1;
-        }
     }
-    else
+    return this->getEndInObj(objId, start, n >= 0 ? start + n : -1);
+}
+
+void DDG::addWritesOfPto(RowId ptoRow, vector<MemAccess> &writes)
+{
+    NodeId dstId = this->storePtrPtos.dstIds[ptoRow];
+    ObjId objId = this->storePtrPtos.objIds[ptoRow];
+    offset_t start = this->storePtrPtos.offsets[ptoRow];
+    for (RowId row : this->storeRelations.byDstId.get(dstId))
     {
-        n = -1;
+        writes.push_back(MemAccess(start, start + this->storeRelations.storeSizes[row], this->storeRelations.storeInstIds[row]));
     }
-
-    for (ObjLoc fromPtee : fromPtees)
+    for (RowId row : this->memCpyRelations.byDstId.get(dstId))
     {
-        ObjId objId = fromPtee.objId;
-        offset_t start = fromPtee.offset;
-        offset_t end = start + (n >= 0) ? n : -1;
+        writes.push_back(MemAccess(start, this->getEnd(objId, start, this->memCpyRelations.nIds[row]), this->memCpyRelations.memCpyInstIds[row]));
+    }
+}
 
-        set<NodeId> storeLikeNodes = this->getStoreLikeNodesOnRange(objId, start, end);
-        for (NodeId storeLikeNode : storeLikeNodes)
-        {
-            boost::add_edge(storeLikeNode, copyOutInstId, this->graph);
-        }
+void DDG::addReadsOfPto(RowId ptoRow, vector<MemAccess> &reads)
+{
+    NodeId srcId = this->loadPtrPtos.srcIds[ptoRow];
+    ObjId objId = this->loadPtrPtos.objIds[ptoRow];
+    offset_t start = this->loadPtrPtos.offsets[ptoRow];
+    for (RowId row : this->loadRelations.bySrcId.get(srcId))
+    {
+        reads.push_back(MemAccess(start, start + this->loadRelations.loadSizes[row], this->loadRelations.loadInstIds[row]));
+    }
+    for (RowId row : this->memCpyRelations.bySrcId.get(srcId))
+    {
+        reads.push_back(MemAccess(start, this->getEnd(objId, start, this->memCpyRelations.nIds[row]), this->memCpyRelations.memCpyInstIds[row]));
+    }
+    for (RowId row : this->copyOutFromRels.byFromId.get(srcId))
+    {
+        NodeId copyOutInstId = this->copyOutFromRels.copyOutInstIds[row];
+        reads.push_back(MemAccess(start, this->getCopyOutEnd(copyOutInstId, objId, start), copyOutInstId));
     }
 }
 
-set<NodeId> DDG::getStoreLikeNodesOnRange(ObjId objId, offset_t start, offset_t end)
+void DDG::collectAccesses(vector<ObjAccesses> &objAccesses)
 {
-    set<NodeId> storeLikeNodes;
-    for (auto &storePtrPto : boost::make_iterator_range(this->storePtrPtos.get<1>().equal_range(objId)))
+    DenseMap<ObjId, uint64_t> obj2Idx;
+    auto getAccesses = [&](ObjId objId) -> ObjAccesses &
     {
-        // store nodes
-        for (auto &storeRelation : boost::make_iterator_range(this->storeRelations.get<StoreRelation::DstId>().equal_range(storePtrPto.dstId)))
+        auto res = obj2Idx.insert(std::make_pair(objId, objAccesses.size()));
+        if (res.second)
         {
-            if (overlap(start, end, storePtrPto.offset, storePtrPto.offset + storeRelation.storeSize))
-            {
-                storeLikeNodes.insert(storeRelation.storeInstId);
-            }
+            objAccesses.emplace_back();
         }
+        return objAccesses[res.first->second];
+    };
 
-        // memcpy nodes
-        for (auto &memCpyRelation : boost::make_iterator_range(this->memCpyRelations.get<MemCpyRelation::DstId>().equal_range(storePtrPto.dstId)))
-        {
-            NodeId nId = memCpyRelation.nId;
-            auto it = this->valNodeSet.find(nId);
-            Value *n = it->val;
-            offset_t memCpyStart = storePtrPto.offset;
-            offset_t memCpyEnd;
-            if (ConstantInt *constantInt = dyn_cast<ConstantInt>(n))
-            {
-                int64_t copySize = constantInt->getSExtValue();
-                memCpyEnd = memCpyStart + copySize;
-            }
-            else
-            {
-                memCpyEnd = -1;
-            }
-            if (overlap(start, end, memCpyStart, memCpyEnd))
-            {
-                storeLikeNodes.insert(memCpyRelation.memCpyInstId);
-            }
-        }
+    for (RowId ptoRow = 0; ptoRow < this->storePtrPtos.size(); ++ptoRow)
+    {
+        this->addWritesOfPto(ptoRow, getAccesses(this->storePtrPtos.objIds[ptoRow]).writes);
+    }
+    for (RowId ptoRow = 0; ptoRow < this->loadPtrPtos.size(); ++ptoRow)
+    {
+        this->addReadsOfPto(ptoRow, getAccesses(this->loadPtrPtos.objIds[ptoRow]).reads);
     }
-    return storeLikeNodes;
 }
 
-set<NodeId> DDG::getStoreLikeNodesOnObj(ObjId objId)
+static void joinWork(vector<ObjAccesses> &objAccesses, vector<vector<pair<NodeId, NodeId>>> &edges, atomic<uint64_t> &next)
 {
-    set<NodeId> storeLikeNodes;
-    for (auto &storePtrPto : boost::make_iterator_range(this->storePtrPtos.get<1>().equal_range(objId)))
+    for (uint64_t i = next++; i < objAccesses.size(); i = next++)
     {
-        // store nodes
-        for (auto &storeRelation : boost::make_iterator_range(this->storeRelations.get<StoreRelation::DstId>().equal_range(storePtrPto.dstId)))
-        {
-            storeLikeNodes.insert(storeRelation.storeInstId);
-        }
+        objAccesses[i].join(edges[i]);
+    }
+}
 
-        // memCpy nodes
-        for (auto &memCpyRelation : boost::make_iterator_range(this->memCpyRelations.get<MemCpyRelation::DstId>().equal_range(storePtrPto.dstId)))
+void DDG::addReadAfterWriteEdges(uint32_t numThreads)
+{
+    vector<ObjAccesses> objAccesses;
+    this->collectAccesses(objAccesses);
+
+    // objects are joined independently
+    vector<vector<pair<NodeId, NodeId>>> edges(objAccesses.size());
+    numThreads = std::min(numThreads, (uint32_t)std::max(objAccesses.size(), (size_t)1));
+    atomic<uint64_t> next(0);
+    vector<thread> threads(numThreads);
+    for (uint32_t t = 0; t < numThreads; ++t)
+    {
+        threads[t] = thread(joinWork, std::ref(objAccesses), std::ref(edges), std::ref(next));
+    }
+    for (uint32_t t = 0; t < numThreads; ++t)
+    {
+        threads[t].join();
+    }
+
+    // in the order of objects, which does not depend on the number of threads
+    for (vector<pair<NodeId, NodeId>> &objEdges : edges)
+    {
+        for (pair<NodeId, NodeId> &edge : objEdges)
         {
-            storeLikeNodes.insert(memCpyRelation.memCpyInstId);
+            boost::add_edge(edge.first, edge.second, this->graph);
         }
     }
-    return storeLikeNodes;
 }
 
 set<NodeId> DDG::getLoadLikeNodesOnObj(ObjId objId)
 {
+    assert(this->relationsFrozen);
     set<NodeId> res;
-    for (auto &loadPtrPto : boost::make_iterator_range(this->loadPtrPtos.get<1>().equal_range(objId)))
+    for (RowId ptoRow : this->loadPtrPtos.byObjId.get(objId))
     {
+        NodeId srcId = this->loadPtrPtos.srcIds[ptoRow];
+
         // load nodes
-        for (auto &loadRelation : boost::make_iterator_range(this->loadRelations.get<LoadRelation::SrcId>().equal_range(loadPtrPto.srcId)))
+        for (RowId row : this->loadRelations.bySrcId.get(srcId))
         {
-            res.insert(loadRelation.loadInstId);
+            res.insert(this->loadRelations.loadInstIds[row]);
         }
 
         // memCpy nodes
-        for (auto &memCpyRel : boost::make_iterator_range(this->memCpyRelations.get<MemCpyRelation::SrcId>().equal_range(loadPtrPto.srcId)))
+        for (RowId row : this->memCpyRelations.bySrcId.get(srcId))
         {
-            res.insert(memCpyRel.memCpyInstId);
+            res.insert(this->memCpyRelations.memCpyInstIds[row]);
         }
 
         // copy-out nodes
-        for (auto &copyOutFromRel : boost::make_iterator_range(this->copyOutFromRels.get<CopyOutFromRel::FromId>().equal_range(loadPtrPto.srcId)))
+        for (RowId row : this->copyOutFromRels.byFromId.get(srcId))
         {
-            res.insert(copyOutFromRel.copyOutInstId);
+            res.insert(this->copyOutFromRels.copyOutInstIds[row]);
         }
     }
     return res;
@@ -484,10 +681,9 @@ set<NodeId> DDG::getLoadLikeNodesOnObj(ObjId objId)
 
 void DDG::dealWithStore(NodeId nodeId)
 {
-    auto it = this->storeNodeSet.find(nodeId);
-    if(it != this->storeNodeSet.end())
+    if (this->getNodeKind(nodeId) == NodeKind::store)
     {
-        StoreInst *storeInst = it->storeInst;
+        StoreInst *storeInst = cast<StoreInst>(this->nodeVals[nodeId]);
         if (storesSensinfo(storeInst))
         {
             outs() << "[++] Ws";
@@ -501,80 +697,243 @@ void DDG::dealWithStore(NodeId nodeId)
     }
 }
 
-void DDG::addAlias(ObjId objId1, ObjId objId2)
+void DDG::addAliasSet(const set<ObjId> &aliasSet)
 {
-    // store obj1, load obj2
-    // TODO: connect others
-    for (auto &storePtrPto : boost::make_iterator_range(this->storePtrPtos.get<1>().equal_range(objId1)))
+    assert(this->relationsFrozen && !this->frozen);
+
+    // the objects are joined as one, so each write meets the reads on every object of the set, in both directions.
+    // The pairs on the same object are connected already, and their edges are removed as duplicates by freeze()
+    ObjAccesses accesses;
+    for (ObjId objId : aliasSet)
     {
-        for (auto &loadPtrPto : boost::make_iterator_range(this->loadPtrPtos.get<1>().equal_range(objId2)))
+        for (RowId ptoRow : this->storePtrPtos.byObjId.get(objId))
         {
-            for (auto &storeRelation : boost::make_iterator_range(this->storeRelations.get<StoreRelation::DstId>().equal_range(storePtrPto.dstId)))
-            {
-                for (auto &loadRelation : boost::make_iterator_range(this->loadRelations.get<LoadRelation::SrcId>().equal_range(loadPtrPto.srcId)))
-                {
-                    if (overlap(storePtrPto.offset, storePtrPto.offset + storeRelation.storeSize, loadPtrPto.offset, loadPtrPto.offset + loadRelation.loadSize))
-                    {
-                        boost::add_edge(storeRelation.storeInstId, loadRelation.loadInstId, this->graph);
-                    }
-                }
-            }
+            this->addWritesOfPto(ptoRow, accesses.writes);
+        }
+        for (RowId ptoRow : this->loadPtrPtos.byObjId.get(objId))
+        {
+            this->addReadsOfPto(ptoRow, accesses.reads);
         }
     }
+
+    vector<pair<NodeId, NodeId>> edges;
+    accesses.join(edges);
+    for (pair<NodeId, NodeId> &edge : edges)
+    {
+        boost::add_edge(edge.first, edge.second, this->graph);
+    }
 }
 
 void DDG::getAffectedNodes(NodeId nodeId, set<NodeId> &loadNodes, set<NodeId> &storeNodes)
 {
+    assert(this->relationsFrozen);
+
     // load
-    for (auto &loadRelation : boost::make_iterator_range(this->loadRelations.get<LoadRelation::SrcId>().equal_range(nodeId)))
+    for (RowId row : this->loadRelations.bySrcId.get(nodeId))
     {
-        loadNodes.insert(loadRelation.loadInstId);
+        loadNodes.insert(this->loadRelations.loadInstIds[row]);
     }
 
     // store
-    for (auto &storeRelation : boost::make_iterator_range(this->storeRelations.get<StoreRelation::DstId>().equal_range(nodeId)))
+    for (RowId row : this->storeRelations.byDstId.get(nodeId))
     {
-        storeNodes.insert(storeRelation.storeInstId);
+        storeNodes.insert(this->storeRelations.storeInstIds[row]);
     }
 
     // memcpy
-    for (auto &memCpyRelation : boost::make_iterator_range(this->memCpyRelations.get<MemCpyRelation::SrcId>().equal_range(nodeId)))
+    for (RowId row : this->memCpyRelations.bySrcId.get(nodeId))
     {
-        loadNodes.insert(memCpyRelation.memCpyInstId);
+        loadNodes.insert(this->memCpyRelations.memCpyInstIds[row]);
     }
-    for (auto &memCpyRelation : boost::make_iterator_range(this->memCpyRelations.get<MemCpyRelation::DstId>().equal_range(nodeId)))
+    for (RowId row : this->memCpyRelations.byDstId.get(nodeId))
     {
-        storeNodes.insert(memCpyRelation.memCpyInstId);
+        storeNodes.insert(this->memCpyRelations.memCpyInstIds[row]);
     }
-    for (auto &memCpyRelation : boost::make_iterator_range(this->memCpyRelations.get<MemCpyRelation::NId>().equal_range(nodeId)))
+    for (RowId row : this->memCpyRelations.byNId.get(nodeId))
     {
-        loadNodes.insert(memCpyRelation.memCpyInstId);
-        storeNodes.insert(memCpyRelation.memCpyInstId);
+        loadNodes.insert(this->memCpyRelations.memCpyInstIds[row]);
+        storeNodes.insert(this->memCpyRelations.memCpyInstIds[row]);
     }
 
     // copy out
-    for (auto &copyOutFromRel : boost::make_iterator_range(this->copyOutFromRels.get<CopyOutFromRel::FromId>().equal_range(nodeId)))
+    for (RowId row : this->copyOutFromRels.byFromId.get(nodeId))
     {
-        loadNodes.insert(copyOutFromRel.copyOutInstId);
+        loadNodes.insert(this->copyOutFromRels.copyOutInstIds[row]);
     }
-    for (auto &copyOutNRel : boost::make_iterator_range(this->copyOutNRels.get<CopyOutNRel::NId>().equal_range(nodeId)))
+    for (RowId row : this->copyOutNRels.byNId.get(nodeId))
     {
-        loadNodes.insert(copyOutNRel.copyOutInstId);
+        loadNodes.insert(this->copyOutNRels.copyOutInstIds[row]);
     }
 }
 
+void DDG::merge(DDG &shard)
+{
+    assert(!this->relationsFrozen && !shard.relationsFrozen);
+    NodeId base = this->nodeKinds.size();
+
+    // nodes
+    this->nodeKinds.insert(this->nodeKinds.end(), shard.nodeKinds.begin(), shard.nodeKinds.end());
+    this->nodeCtxs.insert(this->nodeCtxs.end(), shard.nodeCtxs.begin(), shard.nodeCtxs.end());
+    this->nodeVals.insert(this->nodeVals.end(), shard.nodeVals.begin(), shard.nodeVals.end());
+    for (unsigned kind = 0; kind < numNodeKinds; ++kind)
+    {
+        for (auto &it : shard.key2Node[kind])
+        {
+            this->key2Node[kind][it.first] = it.second + base;
+        }
+    }
+
+    // relations
+    for (const DefUse &defUse : shard.defUseSet)
+    {
+        this->defUseSet.insert(DefUse(defUse.srcId + base, defUse.dstId + base));
+    }
+    const LoadRelations &loads = shard.loadRelations;
+    for (RowId row = 0; row < loads.size(); ++row)
+    {
+        this->loadRelations.add(loads.loadInstIds[row] + base, loads.srcIds[row] + base, loads.valIds[row] + base, loads.loadSizes[row]);
+    }
+    const StoreRelations &stores = shard.storeRelations;
+    for (RowId row = 0; row < stores.size(); ++row)
+    {
+        this->storeRelations.add(stores.storeInstIds[row] + base, stores.valIds[row] + base, stores.dstIds[row] + base, stores.storeSizes[row]);
+    }
+    const MemCpyRelations &memCpys = shard.memCpyRelations;
+    for (RowId row = 0; row < memCpys.size(); ++row)
+    {
+        this->memCpyRelations.add(memCpys.memCpyInstIds[row] + base, memCpys.srcIds[row] + base, memCpys.dstIds[row] + base, memCpys.nIds[row] + base);
+    }
+    const CopyOutFromRels &copyOutFroms = shard.copyOutFromRels;
+    for (RowId row = 0; row < copyOutFroms.size(); ++row)
+    {
+        this->copyOutFromRels.add(copyOutFroms.copyOutInstIds[row] + base, copyOutFroms.fromIds[row] + base);
+    }
+    const CopyOutNRels &copyOutNs = shard.copyOutNRels;
+    for (RowId row = 0; row < copyOutNs.size(); ++row)
+    {
+        this->copyOutNRels.add(copyOutNs.copyOutInstIds[row] + base, copyOutNs.nIds[row] + base);
+    }
+    const LoadPtrPtos &loadPtos = shard.loadPtrPtos;
+    for (RowId row = 0; row < loadPtos.size(); ++row)
+    {
+        this->loadPtrPtos.add(loadPtos.srcIds[row] + base, loadPtos.objIds[row], loadPtos.offsets[row]);
+    }
+    const StorePtrPtos &storePtos = shard.storePtrPtos;
+    for (RowId row = 0; row < storePtos.size(); ++row)
+    {
+        this->storePtrPtos.add(storePtos.dstIds[row] + base, storePtos.objIds[row], storePtos.offsets[row]);
+    }
+
+    // graph
+    for (auto e : boost::make_iterator_range(boost::edges(shard.graph)))
+    {
+        boost::add_edge(boost::source(e, shard.graph) + base, boost::target(e, shard.graph) + base, this->graph);
+    }
+}
+
+static void runTasks(vector<function<void()>> &tasks, atomic<uint32_t> &next)
+{
+    for (uint32_t i = next++; i < tasks.size(); i = next++)
+    {
+        tasks[i]();
+    }
+}
+
+void DDG::freezeRelations(uint32_t numThreads)
+{
+    assert(!this->relationsFrozen);
+    uint64_t numNodes = this->nodeKinds.size();
+
+    // the tables are independent
+    vector<function<void()>> tasks = {
+        [&]() { this->loadRelations.freeze(numNodes); },
+        [&]() { this->storeRelations.freeze(numNodes); },
+        [&]() { this->memCpyRelations.freeze(numNodes); },
+        [&]() { this->copyOutFromRels.freeze(numNodes); },
+        [&]() { this->copyOutNRels.freeze(numNodes); },
+        [&]() { this->loadPtrPtos.freeze(numNodes); },
+        [&]() { this->storePtrPtos.freeze(numNodes); },
+    };
+    uint32_t numTableThreads = std::min(numThreads, (uint32_t)tasks.size());
+    atomic<uint32_t> next(0);
+    vector<thread> threads(numTableThreads);
+    for (uint32_t t = 0; t < numTableThreads; ++t)
+    {
+        threads[t] = thread(runTasks, std::ref(tasks), std::ref(next));
+    }
+    for (uint32_t t = 0; t < numTableThreads; ++t)
+    {
+        threads[t].join();
+    }
+
+    this->addReadAfterWriteEdges(numThreads);
+    this->relationsFrozen = true;
+}
+
+void DDG::freeze()
+{
+    assert(this->relationsFrozen && !this->frozen);
+    uint64_t numNodes = this->nodeKinds.size();
+
+    // successors in the order of their first edges, which is the order bfs discovered them in on the graph
+    vector<NodeId> srcs;
+    vector<NodeId> dsts;
+    vector<NodeId> lastSrc(numNodes, numNodes);
+    srcs.reserve(boost::num_edges(this->graph));
+    dsts.reserve(boost::num_edges(this->graph));
+    for (NodeId src = 0; src < boost::num_vertices(this->graph); ++src)
+    {
+        for (NodeId dst : boost::make_iterator_range(boost::adjacent_vertices(src, this->graph)))
+        {
+            if (lastSrc[dst] != src)
+            {
+                lastSrc[dst] = src;
+                srcs.push_back(src);
+                dsts.push_back(dst);
+            }
+        }
+    }
+    this->graph = Graph();
+    this->succs.build(numNodes, srcs, dsts);
+    this->preds.build(numNodes, dsts, srcs); // sorted by source, as the edges are
+
+    this->searchMarks.assign(numNodes, 0);
+    this->frozen = true;
+}
+
+ArrayRef<NodeId> DDG::getSuccessors(NodeId nodeId) const
+{
+    assert(this->frozen);
+    return this->succs.get(nodeId);
+}
+
+ArrayRef<NodeId> DDG::getPredecessors(NodeId nodeId) const
+{
+    assert(this->frozen);
+    return this->preds.get(nodeId);
+}
+
 uint64_t DDG::getNumNodes()
 {
+    if (this->frozen)
+    {
+        return this->succs.offsets.size() - 1;
+    }
     return boost::num_vertices(this->graph);
 }
 
 uint64_t DDG::getNumEdges()
 {
+    if (this->frozen)
+    {
+        return this->succs.items.size();
+    }
     return boost::num_edges(this->graph);
 }
 
 string DDG::toString()
 {
+    assert(this->relationsFrozen);
     string res;
     res += "DDG(\n";
 
@@ -590,36 +949,38 @@ string DDG::toString()
 
     // load
     res += "Load(\n";
-    for (LoadRelation loadRelation : this->loadRelations)
+    for (RowId row = 0; row < this->loadRelations.size(); ++row)
     {
         res += "{";
-        for (auto &loadPtrPto : boost::make_iterator_range(this->loadPtrPtos.equal_range(loadRelation.srcId)))
+        for (RowId ptoRow : this->loadPtrPtos.bySrcId.get(this->loadRelations.srcIds[row]))
         {
+            offset_t offset = this->loadPtrPtos.offsets[ptoRow];
             res += "(";
-            res += ObjectManager::toString(loadPtrPto.objId) + ", ";
-            res += "[" + to_string(loadPtrPto.offset) + ", " + to_string(loadPtrPto.offset + loadRelation.loadSize) + ")";
+            res += this->objMgr.toString(this->loadPtrPtos.objIds[ptoRow]) + ", ";
+            res += "[" + to_string(offset) + ", " + to_string(offset + this->loadRelations.loadSizes[row]) + ")";
             res += "), ";
         }
         res += "} -> ";
-        res += this->nodeId2String(loadRelation.loadInstId);
+        res += this->nodeId2String(this->loadRelations.loadInstIds[row]);
         res += " -> ";
-        res += this->nodeId2String(loadRelation.valId) + "\n";
+        res += this->nodeId2String(this->loadRelations.valIds[row]) + "\n";
     }
     res += ")\n";
 
     // store
     res += "Store(\n";
-    for (StoreRelation storeRelation : this->storeRelations)
+    for (RowId row = 0; row < this->storeRelations.size(); ++row)
     {
-        res += this->nodeId2String(storeRelation.valId);
+        res += this->nodeId2String(this->storeRelations.valIds[row]);
         res += " -> ";
-        res += this->nodeId2String(storeRelation.storeInstId);
+        res += this->nodeId2String(this->storeRelations.storeInstIds[row]);
         res += " -> {";
-        for (auto &storePtrPto : boost::make_iterator_range(this->storePtrPtos.equal_range(storeRelation.dstId)))
+        for (RowId ptoRow : this->storePtrPtos.byDstId.get(this->storeRelations.dstIds[row]))
         {
+            offset_t offset = this->storePtrPtos.offsets[ptoRow];
             res += "(";
-            res += ObjectManager::toString(storePtrPto.objId) + ", ";
-            res += "[" + to_string(storePtrPto.offset) + ", " + to_string(storePtrPto.offset + storeRelation.storeSize) + ")";
+            res += this->objMgr.toString(this->storePtrPtos.objIds[ptoRow]) + ", ";
+            res += "[" + to_string(offset) + ", " + to_string(offset + this->storeRelations.storeSizes[row]) + ")";
             res += "), ";
         }
         res += "}\n";
@@ -628,24 +989,24 @@ string DDG::toString()
 
     // memCpy
     res += "MemCpy(\n";
-    for (MemCpyRelation memCpyRelation : this->memCpyRelations)
+    for (RowId row = 0; row < this->memCpyRelations.size(); ++row)
     {
         res += "{";
-        for (auto &loadPtrPto : boost::make_iterator_range(this->loadPtrPtos.equal_range(memCpyRelation.srcId)))
+        for (RowId ptoRow : this->loadPtrPtos.bySrcId.get(this->memCpyRelations.srcIds[row]))
         {
             res += "(";
-            res += ObjectManager::toString(loadPtrPto.objId) + ", ";
-            res += "[" + to_string(loadPtrPto.offset) + ", )"; // TODO: end offset
+            res += this->objMgr.toString(this->loadPtrPtos.objIds[ptoRow]) + ", ";
+            res += "[" + to_string(this->loadPtrPtos.offsets[ptoRow]) + ", )"; // TODO: end offset
             res += "), ";
         }
         res += "} -> ";
-        res += this->nodeId2String(memCpyRelation.memCpyInstId);
+        res += this->nodeId2String(this->memCpyRelations.memCpyInstIds[row]);
         res += " -> {";
-        for (auto &storePtrPto : boost::make_iterator_range(this->storePtrPtos.equal_range(memCpyRelation.dstId)))
+        for (RowId ptoRow : this->storePtrPtos.byDstId.get(this->memCpyRelations.dstIds[row]))
         {
             res += "(";
-            res += ObjectManager::toString(storePtrPto.objId) + ", ";
-            res += "[" + to_string(storePtrPto.offset) + ", )"; // TODO: end offset
+            res += this->objMgr.toString(this->storePtrPtos.objIds[ptoRow]) + ", ";
+            res += "[" + to_string(this->storePtrPtos.offsets[ptoRow]) + ", )"; // TODO: end offset
             res += "), ";
         }
         res += "}\n";
@@ -654,18 +1015,18 @@ string DDG::toString()
 
     // copy out
     res += "CopyOut(\n";
-    for (CopyOutFromRel copyOutFromRel : this->copyOutFromRels)
+    for (RowId row = 0; row < this->copyOutFromRels.size(); ++row)
     {
         res += "{";
-        for (auto &loadPtrPto : boost::make_iterator_range(this->loadPtrPtos.equal_range(copyOutFromRel.fromId)))
+        for (RowId ptoRow : this->loadPtrPtos.bySrcId.get(this->copyOutFromRels.fromIds[row]))
         {
             res += "(";
-            res += ObjectManager::toString(loadPtrPto.objId) + ", ";
-            res += "[" + to_string(loadPtrPto.offset) + ", )"; // TODO: end offset
+            res += this->objMgr.toString(this->loadPtrPtos.objIds[ptoRow]) + ", ";
+            res += "[" + to_string(this->loadPtrPtos.offsets[ptoRow]) + ", )"; // TODO: end offset
             res += "), ";
         }
         res += "} -> ";
-        res += this->nodeId2String(copyOutFromRel.copyOutInstId);
+        res += this->nodeId2String(this->copyOutFromRels.copyOutInstIds[row]);
         res += " -> user space\n";
     }
     res += ")\n";
@@ -673,12 +1034,28 @@ string DDG::toString()
     res += ")\n";
 
     res += "Graph(\n";
-    for (auto e : boost::make_iterator_range(boost::edges(this->graph)))
+    if (this->frozen)
     {
-        res += this->nodeId2String(boost::source(e, this->graph));
-        res += " -> ";
-        res += this->nodeId2String(boost::target(e, this->graph));
-        res += "\n";
+        for (NodeId src = 0; src < this->getNumNodes(); ++src)
+        {
+            for (NodeId dst : this->getSuccessors(src))
+            {
+                res += this->nodeId2String(src);
+                res += " -> ";
+                res += this->nodeId2String(dst);
+                res += "\n";
+            }
+        }
+    }
+    else
+    {
+        for (auto e : boost::make_iterator_range(boost::edges(this->graph)))
+        {
+            res += this->nodeId2String(boost::source(e, this->graph));
+            res += " -> ";
+            res += this->nodeId2String(boost::target(e, this->graph));
+            res += "\n";
+        }
     }
     res += ")\n";
 
@@ -707,7 +1084,24 @@ void DDG::bfs(NodeId startId, vector<NodeId> loadLayers)
     set<NodeId> affectedLoads;
     set<NodeId> affectedStores;
     my_visitor vis(*this, reachedCopyOutNodes, unconnectedStores, affectedLoads, affectedStores);
-    boost::breadth_first_search(this->graph, startId, visitor(vis));
+    assert(this->frozen);
+    uint32_t mark = ++this->numSearches;
+    vector<NodeId> queue;
+    queue.push_back(startId);
+    this->searchMarks[startId] = mark;
+    vis.discover_vertex(startId);
+    for (size_t head = 0; head < queue.size(); ++head)
+    {
+        for (NodeId succ : this->getSuccessors(queue[head]))
+        {
+            if (this->searchMarks[succ] != mark)
+            {
+                this->searchMarks[succ] = mark;
+                vis.discover_vertex(succ);
+                queue.push_back(succ);
+            }
+        }
+    }
 
     // info leak
     if (!reachedCopyOutNodes.empty())
@@ -755,10 +1149,9 @@ void DDG::bfs(NodeId startId, vector<NodeId> loadLayers)
         outs() << "[+] Affected stores:\n";
         for (NodeId nodeId : affectedStores)
         {
-            auto it = this->storeNodeSet.find(nodeId);
-            if(it != this->storeNodeSet.end())
+            if (this->getNodeKind(nodeId) == NodeKind::store)
             {
-                StoreInst *storeInst = it->storeInst;
+                StoreInst *storeInst = cast<StoreInst>(this->nodeVals[nodeId]);
                 outs() << "[++] " << string(loadLayers.size(), 'R');
                 if (storesSensinfo(storeInst))
                 {
@@ -780,12 +1173,7 @@ void DDG::bfs(NodeId startId, vector<NodeId> loadLayers)
     }
 }
 
-NodeId DDG::genNodeId()
-{
-    return this->currNodeId++;
-}
-
-void my_visitor::discover_vertex(Graph::vertex_descriptor v, const Graph &g)
+void my_visitor::discover_vertex(NodeId v)
 {
     outs() << "Discovers: " << this->ddg.nodeId2String(v) << "\n";
     switch (this->ddg.getNodeKind(v))
@@ -804,7 +1192,7 @@ void my_visitor::discover_vertex(Graph::vertex_descriptor v, const Graph &g)
     case NodeKind::store:
     case NodeKind::mcpy:
     {
-        if (boost::out_degree(v, g) == 0)
+        if (this->ddg.getSuccessors(v).empty())
         {
             this->unconnectedStores.insert(v);
         }
@@ -815,7 +1203,7 @@ void my_visitor::discover_vertex(Graph::vertex_descriptor v, const Graph &g)
     }
 }
 
-void processLoad(DDG &ddg, Context context, set<ObjLoc> srcPtees, LoadInst *loadInst, Value *src, uint64_t loadSize)
+void processLoad(DDG &ddg, Context context, ArrayRef<ObjLoc> srcPtees, LoadInst *loadInst, Value *src, uint64_t loadSize)
 {
     // TODO: value can be other than stack variable
     NodeId loadInstId = ddg.getOrCreateLoadNode(context, loadInst);
@@ -824,7 +1212,7 @@ void processLoad(DDG &ddg, Context context, set<ObjLoc> srcPtees, LoadInst *load
     ddg.addLoadRelation(loadInstId, srcId, valId, srcPtees, loadSize);
 }
 
-void processStore(DDG &ddg, Context context, Value *val, set<ObjLoc> dstPtees, StoreInst *storeInst, Value *dst, uint64_t storeSize)
+void processStore(DDG &ddg, Context context, Value *val, ArrayRef<ObjLoc> dstPtees, StoreInst *storeInst, Value *dst, uint64_t storeSize)
 {
     // TODO: value can be other than stack variable
     NodeId valId = ddg.getOrCreateValNode(context, val);
@@ -833,7 +1221,7 @@ void processStore(DDG &ddg, Context context, Value *val, set<ObjLoc> dstPtees, S
     ddg.addStoreRelation(storeInstId, valId, dstId, dstPtees, storeSize);
 }
 
-void processMemCpy(DDG &ddg, Context context, llvm::Instruction *memCpyInst, Value *src, set<ObjLoc> srcPtees, Value *dst, std::set<ObjLoc> dstPtees, Value *n)
+void processMemCpy(DDG &ddg, Context context, llvm::Instruction *memCpyInst, Value *src, ArrayRef<ObjLoc> srcPtees, Value *dst, ArrayRef<ObjLoc> dstPtees, Value *n)
 {
     // TODO: value can be other than stack variable
     NodeId memCpyInstId = ddg.getOrCreateMemCpyNode(context, memCpyInst);
@@ -859,7 +1247,7 @@ void processCast(DDG &ddg, Context context, Value *src, CastInst *castInst)
     ddg.addDefUseEdge(srcId, castId);
 }
 
-void processCopyOut(DDG &ddg, Context context, CallInst *callInst, Value *from, set<ObjLoc> fromPtees, Value *n)
+void processCopyOut(DDG &ddg, Context context, CallInst *callInst, Value *from, ArrayRef<ObjLoc> fromPtees, Value *n)
 {
     NodeId copyOutInstId = ddg.getOrCreateCopyOutNode(context, callInst);
     NodeId fromId = ddg.getOrCreateValNode(context, from);
@@ -867,7 +1255,7 @@ void processCopyOut(DDG &ddg, Context context, CallInst *callInst, Value *from,
     ddg.addCopyOutRelation(copyOutInstId, fromId, nId, fromPtees);
 }
 
-void processPrintk(DDG &ddg, Context context, map<Value *, set<ObjLoc>> argPteesMap, CallInst *callInst)
+void processPrintk(DDG &ddg, Context context, map<Value *, ArrayRef<ObjLoc>> argPteesMap, CallInst *callInst)
 {
     NodeId copyOutInstId = ddg.getOrCreateCopyOutNode(context, callInst);
     for (auto &it : argPteesMap)
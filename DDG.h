@@ -1,22 +1,26 @@
 #pragma once
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/IR/Value.h"
 
 #include "InstLoc.h"
 #include "Object.h"
 
 #include <boost/graph/adjacency_list.hpp>
-#include <boost/graph/breadth_first_search.hpp>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/member.hpp>
-#include <boost/multi_index/composite_key.hpp>
 
 #include <map>
 #include <set>
 #include <string>
+#include <tuple>
+#include <vector>
 
 typedef unsigned long NodeId;
+const NodeId noNode = (NodeId)-1; // returned by the lookups of nodes that were never created
 
 // Node of Data Dependence Graph
 
@@ -31,357 +35,196 @@ enum NodeKind
     valout,
 };
 
-// Value node
-class ValNode
-{
-public:
-    NodeId id;
-    Context ctx;
-    llvm::Value *val;
+static const unsigned numNodeKinds = valout + 1;
 
-    ValNode(NodeId id, Context ctx, llvm::Value *val);
-};
+typedef std::pair<ContextId, llvm::Value *> NodeKey; // a value, or the instruction of a node of another kind
 
-typedef boost::multi_index::multi_index_container<
-    ValNode,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_unique<
-            boost::multi_index::member<ValNode, NodeId, &ValNode::id>>,
-        boost::multi_index::ordered_unique<
-            boost::multi_index::composite_key<
-                ValNode,
-                boost::multi_index::member<ValNode, Context, &ValNode::ctx>,
-                boost::multi_index::member<ValNode, llvm::Value *, &ValNode::val>>>>>
-    ValNodeSet;
-
-// Load node
-class LoadNode
+// Edge of Data Dependence Graph
+// Def-use edge
+class DefUse
 {
 public:
-    NodeId id;
-    Context ctx;
-    llvm::LoadInst *loadInst;
+    NodeId srcId;
+    NodeId dstId;
 
-    LoadNode(NodeId id, Context ctx, llvm::LoadInst *loadInst);
+    DefUse(NodeId srcId, NodeId dstId);
 };
 
 typedef boost::multi_index::multi_index_container<
-    LoadNode,
+    DefUse,
     boost::multi_index::indexed_by<
-        boost::multi_index::ordered_unique<
-            boost::multi_index::member<LoadNode, NodeId, &LoadNode::id>>,
-        boost::multi_index::ordered_unique<
-            boost::multi_index::composite_key<
-                LoadNode,
-                boost::multi_index::member<LoadNode, Context, &LoadNode::ctx>,
-                boost::multi_index::member<LoadNode, llvm::LoadInst *, &LoadNode::loadInst>>>>>
-    LoadNodeSet;
-
-// Store node
-class StoreNode
-{
-public:
-    NodeId id;
-    Context ctx;
-    llvm::StoreInst *storeInst;
+        boost::multi_index::ordered_non_unique<
+            boost::multi_index::member<DefUse, NodeId, &DefUse::srcId>>>>
+    DefUseSet;
 
-    StoreNode(NodeId id, Context ctx, llvm::StoreInst *storeInst);
-};
+typedef uint64_t RowId; // a row of a relation table
 
-typedef boost::multi_index::multi_index_container<
-    StoreNode,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_unique<
-            boost::multi_index::member<StoreNode, NodeId, &StoreNode::id>>,
-        boost::multi_index::ordered_unique<
-            boost::multi_index::composite_key<
-                StoreNode,
-                boost::multi_index::member<StoreNode, Context, &StoreNode::ctx>,
-                boost::multi_index::member<StoreNode, llvm::StoreInst *, &StoreNode::storeInst>>>>>
-    StoreNodeSet;
-
-// MemCpy node
-class MemCpyNode
+// A compressed sparse row map from each node to a list: the list of node i is items[offsets[i]] to items[offsets[i + 1] - 1]
+class CSRMap
 {
 public:
-    NodeId id;
-    Context ctx;
-    llvm::Instruction *memCpyInst;
+    std::vector<uint64_t> offsets; // one per node, and the end
+    std::vector<uint64_t> items;
 
-    MemCpyNode(NodeId id, Context ctx, llvm::Instruction *memCpyInst);
+    void build(uint64_t numNodes, llvm::ArrayRef<NodeId> keys, llvm::ArrayRef<uint64_t> values); // list values[i] under keys[i], in order
+    llvm::ArrayRef<uint64_t> get(NodeId nodeId) const;
 };
 
-typedef boost::multi_index::multi_index_container<
-    MemCpyNode,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_unique<
-            boost::multi_index::member<MemCpyNode, NodeId, &MemCpyNode::id>>,
-        boost::multi_index::ordered_unique<
-            boost::multi_index::composite_key<
-                MemCpyNode,
-                boost::multi_index::member<MemCpyNode, Context, &MemCpyNode::ctx>,
-                boost::multi_index::member<MemCpyNode, llvm::Instruction *, &MemCpyNode::memCpyInst>>>>>
-    MemCpyNodeSet;
-
-// Copy-out node
-class CopyOutNode
+// The rows of a relation table by an object column, sorted by object
+class ObjIndex
 {
 public:
-    NodeId id;
-    Context ctx;
-    llvm::CallInst *callInst;
+    std::vector<ObjId> keys;
+    std::vector<RowId> rows;
 
-    CopyOutNode(NodeId id, Context ctx, llvm::CallInst *callInst);
+    void build(llvm::ArrayRef<ObjId> column);
+    llvm::ArrayRef<RowId> get(ObjId objId) const;
 };
 
-typedef boost::multi_index::multi_index_container<
-    CopyOutNode,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_unique<
-            boost::multi_index::member<CopyOutNode, NodeId, &CopyOutNode::id>>,
-        boost::multi_index::ordered_unique<
-            boost::multi_index::composite_key<
-                CopyOutNode,
-                boost::multi_index::member<CopyOutNode, Context, &CopyOutNode::ctx>,
-                boost::multi_index::member<CopyOutNode, llvm::CallInst *, &CopyOutNode::callInst>>>>>
-    CopyOutNodeSet;
-
-// Value-out node
-class ValueOutNode
+// Relations are tables of columns, which rows are appended to while building. freeze() sorts the rows by the first
+// column and builds the indexes in bulk. Tables cannot grow afterwards, and the indexes are only valid afterwards
+
+class LoadRelations
 {
 public:
-    NodeId id;
-    Context ctx;
-    llvm::CallInst *callInst;
+    std::vector<NodeId> loadInstIds;
+    std::vector<NodeId> srcIds;
+    std::vector<NodeId> valIds;
+    std::vector<uint64_t> loadSizes;
+    CSRMap bySrcId;
 
-    ValueOutNode(NodeId id, Context ctx, llvm::CallInst *callInst);
-};
+    bool add(NodeId loadInstId, NodeId srcId, NodeId valId, uint64_t loadSize); // false if the load has a row already
+    RowId size() const;
+    void freeze(uint64_t numNodes);
 
-typedef boost::multi_index::multi_index_container<
-    ValueOutNode,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_unique<
-            boost::multi_index::member<ValueOutNode, NodeId, &ValueOutNode::id>>,
-        boost::multi_index::ordered_unique<
-            boost::multi_index::composite_key<
-                ValueOutNode,
-                boost::multi_index::member<ValueOutNode, Context, &ValueOutNode::ctx>,
-                boost::multi_index::member<ValueOutNode, llvm::CallInst *, &ValueOutNode::callInst>>>>>
-    ValueOutNodeSet;
+private:
+    llvm::DenseSet<NodeId> loadInsts;
+};
 
-// Edge of Data Dependence Graph
-// Def-use edge
-class DefUse
+// Pointees of the pointers that load-like nodes read from
+class LoadPtrPtos
 {
 public:
-    NodeId srcId;
-    NodeId dstId;
+    std::vector<NodeId> srcIds;
+    std::vector<ObjId> objIds;
+    std::vector<offset_t> offsets;
+    CSRMap bySrcId;
+    ObjIndex byObjId;
 
-    DefUse(NodeId srcId, NodeId dstId);
-};
+    bool add(NodeId srcId, ObjId objId, offset_t offset); // false if the row exists
+    RowId size() const;
+    void freeze(uint64_t numNodes);
 
-typedef boost::multi_index::multi_index_container<
-    DefUse,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_non_unique<
-            boost::multi_index::member<DefUse, NodeId, &DefUse::srcId>>>>
-    DefUseSet;
+private:
+    llvm::DenseSet<std::tuple<NodeId, ObjId, offset_t>> rows;
+};
 
-class LoadRelation
+class StoreRelations
 {
 public:
-    NodeId loadInstId;
-    NodeId srcId;
-    NodeId valId;
-    uint64_t loadSize;
+    std::vector<NodeId> storeInstIds;
+    std::vector<NodeId> valIds;
+    std::vector<NodeId> dstIds;
+    std::vector<uint64_t> storeSizes;
+    CSRMap byDstId;
 
-    // tags
-    struct LoadInstId {};
-    struct SrcId {};
-    struct ValId {};
+    bool add(NodeId storeInstId, NodeId valId, NodeId dstId, uint64_t storeSize); // false if the store has a row already
+    RowId size() const;
+    void freeze(uint64_t numNodes);
 
-    LoadRelation(NodeId loadInstId, NodeId srcId, NodeId valId, uint64_t loadSize);
+private:
+    llvm::DenseSet<NodeId> storeInsts;
 };
 
-typedef boost::multi_index::multi_index_container<
-    LoadRelation,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_unique<
-            boost::multi_index::tag<LoadRelation::LoadInstId>,
-            boost::multi_index::member<LoadRelation, NodeId, &LoadRelation::loadInstId>>,
-        boost::multi_index::ordered_non_unique<
-            boost::multi_index::tag<LoadRelation::SrcId>,
-            boost::multi_index::member<LoadRelation, NodeId, &LoadRelation::srcId>>,
-        boost::multi_index::ordered_non_unique<
-            boost::multi_index::tag<LoadRelation::ValId>,
-            boost::multi_index::member<LoadRelation, NodeId, &LoadRelation::valId>>>>
-    LoadRelations;
-
-class LoadPtrPto
+// Pointees of the pointers that store-like nodes write to
+class StorePtrPtos
 {
 public:
-    NodeId srcId;
-    ObjId objId;
-    offset_t offset;
+    std::vector<NodeId> dstIds;
+    std::vector<ObjId> objIds;
+    std::vector<offset_t> offsets;
+    CSRMap byDstId;
+    ObjIndex byObjId;
+
+    bool add(NodeId dstId, ObjId objId, offset_t offset); // false if the row exists
+    RowId size() const;
+    void freeze(uint64_t numNodes);
 
-    LoadPtrPto(NodeId srcId, ObjId objId, offset_t offset);
+private:
+    llvm::DenseSet<std::tuple<NodeId, ObjId, offset_t>> rows;
 };
 
-typedef boost::multi_index::multi_index_container<
-    LoadPtrPto,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_non_unique<
-            boost::multi_index::member<LoadPtrPto, NodeId, &LoadPtrPto::srcId>>,
-        boost::multi_index::ordered_non_unique<
-            boost::multi_index::member<LoadPtrPto, ObjId, &LoadPtrPto::objId>>,
-        boost::multi_index::ordered_unique<
-            boost::multi_index::composite_key<
-                LoadPtrPto,
-                boost::multi_index::member<LoadPtrPto, NodeId, &LoadPtrPto::srcId>,
-                boost::multi_index::member<LoadPtrPto, ObjId, &LoadPtrPto::objId>,
-                boost::multi_index::member<LoadPtrPto, offset_t, &LoadPtrPto::offset>>>>>
-    LoadPtrPtos;
-
-class StoreRelation
+class MemCpyRelations
 {
 public:
-    NodeId storeInstId;
-    NodeId valId;
-    NodeId dstId;
-    uint64_t storeSize;
-
-    // tags
-    struct StoreInstId {};
-    struct ValId {};
-    struct DstId {};
-
-    StoreRelation(NodeId storeInstId, NodeId valId, NodeId dstId, uint64_t storeSize);
+    std::vector<NodeId> memCpyInstIds;
+    std::vector<NodeId> srcIds;
+    std::vector<NodeId> dstIds;
+    std::vector<NodeId> nIds;
+    CSRMap bySrcId;
+    CSRMap byDstId;
+    CSRMap byNId;
+
+    void add(NodeId memCpyInstId, NodeId srcId, NodeId dstId, NodeId nId);
+    RowId size() const;
+    void freeze(uint64_t numNodes);
 };
 
-typedef boost::multi_index::multi_index_container<
-    StoreRelation,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_unique<
-            boost::multi_index::tag<StoreRelation::StoreInstId>,
-            boost::multi_index::member<StoreRelation, NodeId, &StoreRelation::storeInstId>>,
-        boost::multi_index::ordered_non_unique<
-            boost::multi_index::tag<StoreRelation::ValId>,
-            boost::multi_index::member<StoreRelation, NodeId, &StoreRelation::valId>>,
-        boost::multi_index::ordered_non_unique<
-            boost::multi_index::tag<StoreRelation::DstId>,
-            boost::multi_index::member<StoreRelation, NodeId, &StoreRelation::dstId>>>>
-    StoreRelations;
-
-class StorePtrPto
+class CopyOutFromRels
 {
 public:
-    NodeId dstId;
-    ObjId objId;
-    offset_t offset;
+    std::vector<NodeId> copyOutInstIds;
+    std::vector<NodeId> fromIds;
+    CSRMap byFromId;
 
-    StorePtrPto(NodeId dstId, ObjId objId, offset_t offset);
+    void add(NodeId copyOutInstId, NodeId fromId);
+    RowId size() const;
+    void freeze(uint64_t numNodes);
 };
 
-typedef boost::multi_index::multi_index_container<
-    StorePtrPto,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_non_unique<
-            boost::multi_index::member<StorePtrPto, NodeId, &StorePtrPto::dstId>>,
-        boost::multi_index::ordered_non_unique<
-            boost::multi_index::member<StorePtrPto, ObjId, &StorePtrPto::objId>>,
-        boost::multi_index::ordered_unique<
-            boost::multi_index::composite_key<
-                StorePtrPto,
-                boost::multi_index::member<StorePtrPto, NodeId, &StorePtrPto::dstId>,
-                boost::multi_index::member<StorePtrPto, ObjId, &StorePtrPto::objId>,
-                boost::multi_index::member<StorePtrPto, offset_t, &StorePtrPto::offset>>>>>
-    StorePtrPtos;
-
-class MemCpyRelation
+class CopyOutNRels
 {
 public:
-    NodeId memCpyInstId;
-    NodeId srcId;
-    NodeId dstId;
-    NodeId nId;
-
-    // tags
-    struct SrcId {};
-    struct DstId {};
-    struct NId {};
-
-    MemCpyRelation(NodeId memCpyInstId, NodeId srcId, NodeId dstId, NodeId nId);
+    std::vector<NodeId> copyOutInstIds;
+    std::vector<NodeId> nIds;
+    CSRMap byCopyOutInstId;
+    CSRMap byNId;
+
+    void add(NodeId copyOutInstId, NodeId nId);
+    RowId size() const;
+    void freeze(uint64_t numNodes);
 };
 
-typedef boost::multi_index::multi_index_container<
-    MemCpyRelation,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_non_unique<
-            boost::multi_index::tag<MemCpyRelation::SrcId>,
-            boost::multi_index::member<MemCpyRelation, NodeId, &MemCpyRelation::srcId>>,
-        boost::multi_index::ordered_non_unique<
-            boost::multi_index::tag<MemCpyRelation::DstId>,
-            boost::multi_index::member<MemCpyRelation, NodeId, &MemCpyRelation::dstId>>,
-        boost::multi_index::ordered_non_unique<
-            boost::multi_index::tag<MemCpyRelation::NId>,
-            boost::multi_index::member<MemCpyRelation, NodeId, &MemCpyRelation::nId>>>>
-    MemCpyRelations;
-
-class CopyOutFromRel
+// A read or a write of an object range by a load-like or a store-like node
+class MemAccess
 {
 public:
-    NodeId copyOutInstId;
-    NodeId fromId;
-
-    // tags
-    struct CopyOutInstId {};
-    struct FromId {};
+    offset_t start;
+    offset_t end; // -1 for an unknown length
+    NodeId nodeId;
 
-    CopyOutFromRel(NodeId copyOutInstId, NodeId fromId);
+    MemAccess(offset_t start, offset_t end, NodeId nodeId);
+    bool operator<(const MemAccess &rhs) const; // by start
+    bool operator==(const MemAccess &rhs) const;
 };
 
-typedef boost::multi_index::multi_index_container<
-    CopyOutFromRel,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_non_unique<
-            boost::multi_index::tag<CopyOutFromRel::CopyOutInstId>,
-            boost::multi_index::member<CopyOutFromRel, NodeId, &CopyOutFromRel::copyOutInstId>>,
-        boost::multi_index::ordered_non_unique<
-            boost::multi_index::tag<CopyOutFromRel::FromId>,
-            boost::multi_index::member<CopyOutFromRel, NodeId, &CopyOutFromRel::fromId>>>>
-    CopyOutFromRels;
-
-class CopyOutNRel
+// The accesses of one object, joined into read-after-write edges once the relations are complete
+class ObjAccesses
 {
 public:
-    NodeId copyOutInstId;
-    NodeId nId;
-
-    // tags
-    struct CopyOutInstId {};
-    struct NId {};
+    std::vector<MemAccess> writes;
+    std::vector<MemAccess> reads;
 
-    CopyOutNRel(NodeId copyOutInstId, NodeId nId);
+    void join(std::vector<std::pair<NodeId, NodeId>> &edges); // (store-like, load-like) of the overlapping accesses, without duplicates
 };
 
-typedef boost::multi_index::multi_index_container<
-    CopyOutNRel,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_non_unique<
-            boost::multi_index::tag<CopyOutNRel::CopyOutInstId>,
-            boost::multi_index::member<CopyOutNRel, NodeId, &CopyOutNRel::copyOutInstId>>,
-        boost::multi_index::ordered_non_unique<
-            boost::multi_index::tag<CopyOutNRel::NId>,
-            boost::multi_index::member<CopyOutNRel, NodeId, &CopyOutNRel::nId>>>>
-    CopyOutNRels;
-
 typedef boost::adjacency_list<> Graph;
 
 // Data Dependence Graph
 class DDG
 {
 public:
-    DDG();
+    DDG(const ObjectManager &objMgr);
 
     NodeId getOrCreateValNode(Context context, llvm::Value *val);
     NodeId getOrCreateLoadNode(Context context, llvm::LoadInst *loadInst);
@@ -389,42 +232,52 @@ public:
     NodeId getOrCreateMemCpyNode(Context context, llvm::Instruction *memCpyInst);
     NodeId getOrCreateCopyOutNode(Context context, llvm::CallInst *callInst);
     NodeId getOrCreateValOutNode(Context context, llvm::CallInst *callInst);
+    NodeId findLoadNode(Context context, llvm::LoadInst *loadInst) const; // noNode if it does not exist
+    NodeId findMemCpyNode(Context context, llvm::Instruction *memCpyInst) const; // noNode if it does not exist
     NodeKind getNodeKind(NodeId nodeId) const;
     std::string nodeId2String(NodeId nodeId, bool hasSrcLoc = true);
 
     void addDefUseEdge(NodeId src, NodeId dst);
-    void addLoadRelation(NodeId loadInstId, NodeId srcId, NodeId valId, std::set<ObjLoc> srcPtees, uint64_t loadSize);
-    void addStoreRelation(NodeId storeInstId, NodeId valId, NodeId dstId, std::set<ObjLoc> dstPtees, uint64_t storeSize);
-    void addMemCpy(NodeId memCpyInstId, NodeId srcId, NodeId dstId, NodeId nId, std::set<ObjLoc> srcPtees, std::set<ObjLoc> dstPtees);
-    void addCopyOutRelation(NodeId copyOutInstId, NodeId fromId, NodeId nId, std::set<ObjLoc> fromPtees);
-    std::set<NodeId> getStoreLikeNodesOnRange(ObjId loadObjId, offset_t loadStart, offset_t loadEnd);
+    void addLoadRelation(NodeId loadInstId, NodeId srcId, NodeId valId, llvm::ArrayRef<ObjLoc> srcPtees, uint64_t loadSize);
+    void addStoreRelation(NodeId storeInstId, NodeId valId, NodeId dstId, llvm::ArrayRef<ObjLoc> dstPtees, uint64_t storeSize);
+    void addMemCpy(NodeId memCpyInstId, NodeId srcId, NodeId dstId, NodeId nId, llvm::ArrayRef<ObjLoc> srcPtees, llvm::ArrayRef<ObjLoc> dstPtees);
+    void addCopyOutRelation(NodeId copyOutInstId, NodeId fromId, NodeId nId, llvm::ArrayRef<ObjLoc> fromPtees);
     std::set<NodeId> getStoreLikeNodesOnObj(ObjId objId);
     std::set<NodeId> getLoadLikeNodesOnObj(ObjId objId);
     void dealWithStore(NodeId nodeId);
 
-    // should be called after finishing building the graph
-    void addAlias(ObjId objId1, ObjId objId2);
+    // sort the relations, build their indexes and connect the store-like nodes to the load-like nodes that read
+    // what they write, on numThreads threads. No relations can be added afterwards, and the queries on them need it
+    void freezeRelations(uint32_t numThreads);
+
+    // connect the store-like nodes on any object of an alias set to the load-like nodes on any object of it that
+    // read what they write. Should be called between freezeRelations() and freeze()
+    void addAliasSet(const std::set<ObjId> &aliasSet);
+
+    // append the graph of a later entry, numbering its nodes after the existing ones
+    void merge(DDG &shard);
+
+    // compact the graph, without duplicate edges, for the queries below. No edges can be added afterwards
+    void freeze();
+    llvm::ArrayRef<NodeId> getSuccessors(NodeId nodeId) const; // after freeze()
+    llvm::ArrayRef<NodeId> getPredecessors(NodeId nodeId) const; // after freeze()
 
     void getAffectedNodes(NodeId nodeId, std::set<NodeId> &loadNodes, std::set<NodeId> &storeNodes);
 
     uint64_t getNumNodes(); // the number of nodes in the graph
-    uint64_t getNumEdges(); // the number of edges in the graph
+    uint64_t getNumEdges(); // the number of edges in the graph, without duplicates once frozen
     std::string toString();
 
     void bfs(NodeId startId, std::vector<NodeId> loadLayers);
 
 private:
-    // next node id to be used
-    NodeId currNodeId;
-
-    // nodes
-    std::map<NodeId, NodeKind> nodeKindMap;
-    ValNodeSet valNodeSet;
-    LoadNodeSet loadNodeSet;
-    StoreNodeSet storeNodeSet;
-    MemCpyNodeSet memCpyNodeSet;
-    CopyOutNodeSet copyOutNodeSet;
-    ValueOutNodeSet valueOutNodeSet;
+    const ObjectManager &objMgr; // for the bounds of objects
+
+    // nodes, as a struct of arrays indexed by NodeId
+    std::vector<NodeKind> nodeKinds;
+    std::vector<ContextId> nodeCtxs;
+    std::vector<llvm::Value *> nodeVals; // the value of a value node, the instruction of the others
+    llvm::DenseMap<NodeKey, NodeId> key2Node[numNodeKinds]; // per kind, as a load and its loaded value share the instruction
 
     // edges
     DefUseSet defUseSet; // info edges (among values)
@@ -437,14 +290,28 @@ private:
     // alias info
     LoadPtrPtos loadPtrPtos;
     StorePtrPtos storePtrPtos;
+    bool relationsFrozen;
 
     // graph
-    Graph graph; // info edges (among values + loads + stores + ...)
-
-    NodeId genNodeId();
+    Graph graph; // info edges (among values + loads + stores + ...), with duplicates, while building
+    bool frozen;
+    CSRMap succs; // the edges of graph once frozen
+    CSRMap preds; // the reversed edges, sorted by source
+    std::vector<uint32_t> searchMarks; // the last bfs that discovered each node
+    uint32_t numSearches;
+
+    NodeId getOrCreateNode(NodeKind kind, Context context, llvm::Value *val); // before freeze()
+    NodeId findNode(NodeKind kind, Context context, llvm::Value *val) const;
+    offset_t getEnd(ObjId objId, offset_t start, NodeId nId); // start + the length in nId if it is constant, or else as getEndInObj()
+    offset_t getEndInObj(ObjId objId, offset_t start, offset_t end); // end, or else the end of the object if the access starts inside it, or -1
+    offset_t getCopyOutEnd(NodeId copyOutInstId, ObjId objId, offset_t start);
+    void addWritesOfPto(RowId ptoRow, std::vector<MemAccess> &writes); // of the store-like nodes through a row of storePtrPtos
+    void addReadsOfPto(RowId ptoRow, std::vector<MemAccess> &reads); // of the load-like nodes through a row of loadPtrPtos
+    void collectAccesses(std::vector<ObjAccesses> &objAccesses); // grouped by object
+    void addReadAfterWriteEdges(uint32_t numThreads);
 };
 
-class my_visitor : public boost::default_bfs_visitor
+class my_visitor
 {
 public:
     DDG &ddg;
@@ -454,16 +321,16 @@ public:
     std::set<NodeId> &affectedStores;
 
     my_visitor(DDG &ddg, std::set<NodeId> &reachedCopyOutNodes, std::set<NodeId> &unconnectedStores, std::set<NodeId> &affectedLoads, std::set<NodeId> &affectedStores) : ddg(ddg), reachedCopyOutNodes(reachedCopyOutNodes), unconnectedStores(unconnectedStores), affectedLoads(affectedLoads), affectedStores(affectedStores){};
-    void discover_vertex(Graph::vertex_descriptor v, const Graph &g);
+    void discover_vertex(NodeId v);
 };
 
-void processLoad(DDG &ddg, Context context, std::set<ObjLoc> srcPtees, llvm::LoadInst *loadInst, llvm::Value *src, uint64_t loadSize);
-void processStore(DDG &ddg, Context context, llvm::Value *val, std::set<ObjLoc> dstPtees, llvm::StoreInst *storeInst, llvm::Value *dst, uint64_t storeSize);
-void processMemCpy(DDG &ddg, Context context, llvm::Instruction *memCpyInst, llvm::Value *src, std::set<ObjLoc> srcPtees, llvm::Value *dst, std::set<ObjLoc> dstPtees, llvm::Value *n);
+void processLoad(DDG &ddg, Context context, llvm::ArrayRef<ObjLoc> srcPtees, llvm::LoadInst *loadInst, llvm::Value *src, uint64_t loadSize);
+void processStore(DDG &ddg, Context context, llvm::Value *val, llvm::ArrayRef<ObjLoc> dstPtees, llvm::StoreInst *storeInst, llvm::Value *dst, uint64_t storeSize);
+void processMemCpy(DDG &ddg, Context context, llvm::Instruction *memCpyInst, llvm::Value *src, llvm::ArrayRef<ObjLoc> srcPtees, llvm::Value *dst, llvm::ArrayRef<ObjLoc> dstPtees, llvm::Value *n);
 void processGEP(DDG &ddg, Context context, llvm::Value *ptr, llvm::GetElementPtrInst *gepInst);
 void processCast(DDG &ddg, Context context, llvm::Value *src, llvm::CastInst *castInst);
-void processCopyOut(DDG &ddg, Context context, llvm::CallInst *callInst, llvm::Value *from, std::set<ObjLoc> fromPtees, llvm::Value *n);
-void processPrintk(DDG &ddg, Context context, std::map<llvm::Value *, std::set<ObjLoc>> argPteesMap, llvm::CallInst *callInst);
+void processCopyOut(DDG &ddg, Context context, llvm::CallInst *callInst, llvm::Value *from, llvm::ArrayRef<ObjLoc> fromPtees, llvm::Value *n);
+void processPrintk(DDG &ddg, Context context, std::map<llvm::Value *, llvm::ArrayRef<ObjLoc>> argPteesMap, llvm::CallInst *callInst);
 void processValueOut(DDG &ddg, Context context, llvm::Value *val, llvm::CallInst *callInst);
 void processCall(DDG &ddg, Context callerCtx, llvm::Value *arg, Context calleeCtx, llvm::Argument *parm);
 void processRet(DDG &ddg, Context calleeCtx, llvm::Value *retVal, Context callerCtx, llvm::Instruction *callInst);
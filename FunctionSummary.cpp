@@ -0,0 +1,172 @@
+#include "llvm/IR/InstIterator.h"
+
+#include "FunctionSummary.h"
+
+#include <set>
+
+using namespace llvm;
+using namespace std;
+
+FunctionSummary::FunctionSummary(Context ctx, PteeSetId retPtees) : ctx(ctx), retPtees(retPtees)
+{
+}
+
+FunctionSummaryCache::FunctionSummaryCache(PointsToRecords &ptoRecords, DDG &ddg) : ptoRecords(ptoRecords), ddg(ddg), numSummaries(0), numReused(0)
+{
+}
+
+const FunctionSummary *FunctionSummaryCache::find(Function *func, uint32_t remainingDepth, ArrayRef<PteeSetId> argPtees, Context calleeCtx)
+{
+    auto it = this->summaries.find(std::make_tuple(func, remainingDepth, vector<PteeSetId>(argPtees.begin(), argPtees.end())));
+    if (it == this->summaries.end())
+    {
+        return nullptr;
+    }
+    for (const FunctionSummary &summary : it->second)
+    {
+        bool sameLoads = true;
+        for (const pair<ObjLoc, PteeSetId> &load : summary.loads)
+        {
+            if (this->ptoRecords.getPteesBeforeCall(load.first, calleeCtx) != load.second)
+            {
+                sameLoads = false;
+                break;
+            }
+        }
+        if (sameLoads)
+        {
+            return &summary;
+        }
+    }
+    return nullptr;
+}
+
+void FunctionSummaryCache::apply(const FunctionSummary &summary, CallInst *callInst, Context callerCtx, Context calleeCtx)
+{
+    Function *func = summary.ctx.getCurrentFunction();
+
+    // arguments flow into the parameters of the analyzed context
+    User::op_iterator arg = callInst->arg_begin();
+    User::op_iterator argEnd = callInst->arg_end();
+    Function::arg_iterator parm = func->arg_begin();
+    Function::arg_iterator parmEnd = func->arg_end();
+    for (; arg != argEnd && parm != parmEnd; arg++, parm++)
+    {
+        processCall(this->ddg, callerCtx, (*arg).get(), summary.ctx, &(*parm));
+    }
+
+    // return value
+    this->ptoRecords.addPteesForValPtr(callerCtx, callInst, summary.retPtees);
+    for (Value *retVal : summary.retVals)
+    {
+        processRet(this->ddg, summary.ctx, retVal, callerCtx, callInst);
+    }
+
+    // the updates happen somewhere inside the call, so they are replayed at the call
+    InstLoc callLoc(callerCtx, callInst);
+    for (const ObjPtoUpdate &update : summary.updates)
+    {
+        this->ptoRecords.addPteesForObjPtr(update.pointer, update.pointees, callLoc);
+    }
+
+    // a summary that encloses the call also depends on what the call loaded
+    if (!this->logStarts.empty())
+    {
+        for (const pair<ObjLoc, PteeSetId> &load : summary.loads)
+        {
+            this->ptoRecords.getLoadLog().push_back(load.first);
+        }
+    }
+
+    this->replayed2Analyzed[calleeCtx.id] = summary.ctx.id;
+    this->numReused++;
+}
+
+void FunctionSummaryCache::beginSummary()
+{
+    if (this->logStarts.empty())
+    {
+        this->ptoRecords.setLogAccesses(true);
+    }
+    this->logStarts.push_back(std::make_pair(this->ptoRecords.getUpdateLog().size(), this->ptoRecords.getLoadLog().size()));
+}
+
+void FunctionSummaryCache::addSummary(Function *func, uint32_t remainingDepth, ArrayRef<PteeSetId> argPtees, Context ctx, PteeSetId retPtees)
+{
+    pair<uint64_t, uint64_t> logStart = this->logStarts.back();
+    this->logStarts.pop_back();
+
+    FunctionSummary summary(ctx, retPtees);
+    for (inst_iterator I = inst_begin(func), E = inst_end(func); I != E; ++I)
+    {
+        if (ReturnInst *retInst = dyn_cast<ReturnInst>(&*I))
+        {
+            if (Value *retVal = retInst->getReturnValue())
+            {
+                summary.retVals.push_back(retVal);
+            }
+        }
+    }
+
+    // keep the first occurrence of each update
+    vector<ObjPtoUpdate> &updateLog = this->ptoRecords.getUpdateLog();
+    set<pair<ObjLoc, PteeSetId>> seen;
+    for (uint64_t i = logStart.first; i < updateLog.size(); ++i)
+    {
+        if (seen.insert(std::make_pair(updateLog[i].pointer, updateLog[i].pointees)).second)
+        {
+            summary.updates.push_back(updateLog[i]);
+        }
+    }
+
+    // the pointees of each loaded object at the call, i.e. of the versions written outside ctx
+    vector<ObjLoc> &loadLog = this->ptoRecords.getLoadLog();
+    set<ObjLoc> loaded(loadLog.begin() + logStart.second, loadLog.end());
+    for (ObjLoc pointer : loaded)
+    {
+        summary.loads.push_back(std::make_pair(pointer, this->ptoRecords.getPteesBeforeCall(pointer, ctx)));
+    }
+
+    // the logs are only needed while some summary is being built
+    if (this->logStarts.empty())
+    {
+        this->ptoRecords.setLogAccesses(false);
+        updateLog.clear();
+        loadLog.clear();
+    }
+
+    this->summaries[std::make_tuple(func, remainingDepth, vector<PteeSetId>(argPtees.begin(), argPtees.end()))].push_back(summary);
+    this->numSummaries++;
+}
+
+const DenseMap<ContextId, ContextId> &FunctionSummaryCache::getReplayedContexts() const
+{
+    return this->replayed2Analyzed;
+}
+
+Context FunctionSummaryCache::getAnalyzedContext(Context context, const DenseMap<ContextId, ContextId> &replayed2Analyzed)
+{
+    ContextNode node = ContextManager::getNode(context.id); // copied, creating a child may move the nodes
+    if (node.depth == 1)
+    {
+        return context;
+    }
+    Context parent = FunctionSummaryCache::getAnalyzedContext(Context(node.parent), replayed2Analyzed);
+    Context child(ContextManager::getOrCreateChild(parent.id, node.callInst, node.func));
+    auto it = replayed2Analyzed.find(child.id);
+    if (it != replayed2Analyzed.end())
+    {
+        return Context(it->second);
+    }
+    return child;
+}
+
+uint64_t FunctionSummaryCache::getNumSummaries() const
+{
+    return this->numSummaries;
+}
+
+uint64_t FunctionSummaryCache::getNumReused() const
+{
+    return this->numReused;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/Instructions.h"
+
+#include "DDG.h"
+#include "InstLoc.h"
+#include "PointsTo.h"
+
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// The effects of analyzing a function once for some points-to of its arguments
+class FunctionSummary
+{
+public:
+    Context ctx; // the context in which the function was analyzed; its DDG nodes are shared by all users
+    PteeSetId retPtees;
+    std::vector<llvm::Value *> retVals; // returned values, for DDG edges to the callers
+    std::vector<ObjPtoUpdate> updates; // updates of objects by the function and its callees, without duplicates
+    std::vector<std::pair<ObjLoc, PteeSetId>> loads; // objects loaded by the function and its callees, and their pointees at the call
+
+    FunctionSummary(Context ctx, PteeSetId retPtees);
+};
+
+// Summaries of the analyzed functions of one entry, keyed by the function, the call depth left below it, which bounds
+// the nested calls it analyzed, and the points-to of its arguments.
+// A call with a known key is not analyzed again if the objects loaded by a summary of the key still have the same
+// pointees at the call. Then the function sees the same memory, so the updates of the summary are replayed at the
+// call, as weak updates, and the DDG nodes of the arguments and the return value are connected to the analyzed context
+class FunctionSummaryCache
+{
+public:
+    FunctionSummaryCache(PointsToRecords &ptoRecords, DDG &ddg);
+
+    const FunctionSummary *find(llvm::Function *func, uint32_t remainingDepth, llvm::ArrayRef<PteeSetId> argPtees, Context calleeCtx);
+    void apply(const FunctionSummary &summary, llvm::CallInst *callInst, Context callerCtx, Context calleeCtx);
+
+    // log the object accesses from here to the matching addSummary()
+    void beginSummary();
+    void addSummary(llvm::Function *func, uint32_t remainingDepth, llvm::ArrayRef<PteeSetId> argPtees, Context ctx, PteeSetId retPtees);
+
+    // callee contexts of the calls that reused a summary -> contexts in which the summaries were analyzed
+    const llvm::DenseMap<ContextId, ContextId> &getReplayedContexts() const;
+
+    // the context in which the instructions of context were analyzed, which differs if a call on it was summarized
+    static Context getAnalyzedContext(Context context, const llvm::DenseMap<ContextId, ContextId> &replayed2Analyzed);
+
+    uint64_t getNumSummaries() const;
+    uint64_t getNumReused() const;
+
+private:
+    PointsToRecords &ptoRecords;
+    DDG &ddg;
+    std::map<std::tuple<llvm::Function *, uint32_t, std::vector<PteeSetId>>, std::vector<FunctionSummary>> summaries;
+    llvm::DenseMap<ContextId, ContextId> replayed2Analyzed;
+    std::vector<std::pair<uint64_t, uint64_t>> logStarts; // sizes of the update and load logs when each summary being built began
+    uint64_t numSummaries;
+    uint64_t numReused;
+};
@@ -1,30 +1,67 @@
+#include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/TypeFinder.h"
+#include "llvm/Support/Error.h"
 
 #include "GlobalState.h"
+#include "ParseIR.h"
+
+#include <algorithm>
 
 using namespace llvm;
 using namespace std;
 
-GlobalState::GlobalState(vector<Module *> MList, ostream &out) : out(out), outFunctions{"out_functions"}, outTypes{"out_types"}
+ModuleFacts::ModuleFacts(uint32_t moduleIdx, Module &M) : moduleIdx(moduleIdx), M(&M)
 {
-    for (Module *M : MList)
+    // functions
+    // unmaterialized functions are not declarations, so lazily loaded modules are indexed by their symbols only
+    for (Function &F : M)
     {
-        if (M)
+        if (!F.isDeclaration() && (F.hasExternalLinkage() || F.hasInternalLinkage() || F.hasWeakLinkage()))
         {
-            this->moduleList.push_back(M);
-            this->genModuleFacts(*M); // generate facts for each module
+            this->funcDefs.push_back(&F);
         }
     }
 
-    // resolve weak function definitioin
-    for (auto &it : this->name2WeakGlbFuncDef)
+    // types
+    TypeFinder typeFinder;
+    typeFinder.run(M, false);
+    for (TypeFinder::iterator itr = typeFinder.begin(), ite = typeFinder.end(); itr != ite; ++itr)
     {
-        if (this->name2GlbFuncDef.find(it.first) == this->name2GlbFuncDef.end())
+        StructType *st = *itr;
+        if (st->isLiteral())
         {
-            this->name2GlbFuncDef[it.first] = it.second;
+            // TODO: don't know what is literal
+            continue;
+        }
+        if (!st->isOpaque())
+        {
+            this->structTypes.push_back(st);
         }
     }
-    this->name2WeakGlbFuncDef.clear();
+}
+
+GlobalState::GlobalState(vector<Module *> MList, ostream &out) : out(out), outFunctions{"out_functions"}, outTypes{"out_types"}
+{
+    vector<SymbolShard> shards(1);
+    for (uint32_t i = 0; i < MList.size(); ++i)
+    {
+        if (MList[i])
+        {
+            shards[0].push_back(ModuleFacts(i, *MList[i])); // generate facts for each module
+        }
+    }
+    this->mergeShards(shards, MList.size());
+}
+
+GlobalState::GlobalState(vector<string> inputFilenames, ostream &out, uint32_t numThreads, bool lazyLoad) : out(out), outFunctions{"out_functions"}, outTypes{"out_types"}
+{
+    // each parsing thread extracts the facts of its modules into its own shard
+    vector<SymbolShard> shards(getNumThreads(numThreads));
+    forEachIRFileMultithread(inputFilenames, out, numThreads, lazyLoad, [&shards](uint32_t threadIdx, uint32_t fileIdx, Module *M) {
+        shards[threadIdx].push_back(ModuleFacts(fileIdx, *M));
+    });
+    this->mergeShards(shards, inputFilenames.size());
 }
 
 std::vector<llvm::Module *> &GlobalState::getModuleList()
@@ -32,131 +69,214 @@ std::vector<llvm::Module *> &GlobalState::getModuleList()
     return this->moduleList;
 }
 
-void GlobalState::genModuleFacts(Module &M)
+void GlobalState::mergeShards(vector<SymbolShard> &shards, uint32_t numModules)
+{
+    // merge in input order, so that the result does not depend on which thread parsed which module
+    vector<ModuleFacts *> factsOfModule(numModules, nullptr);
+    for (SymbolShard &shard : shards)
+    {
+        for (ModuleFacts &facts : shard)
+        {
+            factsOfModule[facts.moduleIdx] = &facts;
+        }
+    }
+    for (ModuleFacts *facts : factsOfModule)
+    {
+        if (facts)
+        {
+            this->moduleList.push_back(facts->M);
+            this->addModuleFacts(*facts);
+        }
+    }
+
+    // resolve weak function definitioin
+    for (auto &it : this->name2WeakGlbFuncDef)
+    {
+        this->name2GlbFuncDef.insert(std::make_pair(it.getKey(), it.getValue())); // no-op if a strong definition exists
+    }
+    this->name2WeakGlbFuncDef.clear();
+
+    // all definitions of each name, answered without allocation by getFuncDefs
+    for (auto &it : this->name2GlbFuncDef)
+    {
+        this->name2FuncDefs[it.getKey()].push_back(it.getValue());
+    }
+    for (auto &it : this->name2InternalFuncDef)
+    {
+        auto &defs = this->name2FuncDefs[it.getKey()];
+        defs.append(it.getValue().begin(), it.getValue().end());
+    }
+}
+
+void GlobalState::addModuleFacts(ModuleFacts &facts)
 {
     // functions
-    for (Function &F : M)
+    for (Function *def : facts.funcDefs)
     {
-        if (!F.isDeclaration())
+        Function &F = *def;
+        StringRef name = F.getName();
+        if (F.hasExternalLinkage())
         {
-            string name = F.getName().str();
-            auto linkage = F.getLinkage();
-            if (F.hasExternalLinkage())
+            auto it = this->name2GlbFuncDef.find(name);
+            if (it != this->name2GlbFuncDef.end())
             {
-                auto it = this->name2GlbFuncDef.find(name);
-                if (it != this->name2GlbFuncDef.end())
-                {
-                    this->outFunctions << "[-] Function " << name << " already defined in " << it->second->getParent()->getModuleIdentifier() << ".\n";
-                    this->outFunctions << "[-] Now comes a second definition in " << F.getParent()->getModuleIdentifier() << ".\n";
-                }
-                this->name2GlbFuncDef[name] = &F;
+                this->outFunctions << "[-] Function " << name.str() << " already defined in " << it->second->getParent()->getModuleIdentifier() << ".\n";
+                this->outFunctions << "[-] Now comes a second definition in " << F.getParent()->getModuleIdentifier() << ".\n";
             }
-            else if (F.hasInternalLinkage())
-            {
-                this->name2InternalFuncDef.insert(std::make_pair(name, &F));
-            }
-            else if (F.hasWeakLinkage())
+            this->name2GlbFuncDef[name] = &F;
+        }
+        else if (F.hasInternalLinkage())
+        {
+            this->name2InternalFuncDef[name].push_back(&F);
+        }
+        else if (F.hasWeakLinkage())
+        {
+            auto it = this->name2WeakGlbFuncDef.find(name);
+            if (it != this->name2WeakGlbFuncDef.end())
             {
-                auto it = this->name2WeakGlbFuncDef.find(name);
-                if (it != this->name2WeakGlbFuncDef.end())
-                {
-                    this->outFunctions << "[-] Weak Function " << name << " already defined in " << it->second->getParent()->getModuleIdentifier() << ".\n";
-                    this->outFunctions << "[-] Now comes a second definition in " << F.getParent()->getModuleIdentifier() << ".\n";
-                }
-                this->name2WeakGlbFuncDef[name] = &F;
+                this->outFunctions << "[-] Weak Function " << name.str() << " already defined in " << it->second->getParent()->getModuleIdentifier() << ".\n";
+                this->outFunctions << "[-] Now comes a second definition in " << F.getParent()->getModuleIdentifier() << ".\n";
             }
+            this->name2WeakGlbFuncDef[name] = &F;
         }
     }
 
     // types
-    TypeFinder typeFinder;
-    typeFinder.run(M, false);
-    for (TypeFinder::iterator itr = typeFinder.begin(), ite = typeFinder.end(); itr != ite; ++itr)
+    for (StructType *st : facts.structTypes)
     {
-        StructType *st = *itr;
-        if (st->isLiteral())
-        {
-            // TODO: don't know what is literal
-            continue;
-        }
-        if (!st->isOpaque())
-        {
-            string structName = st->getStructName().str();
-            this->name2StructType.insert(std::make_pair(structName, std::make_pair(&M, st)));
-        }
+        this->name2StructType[st->getStructName()].push_back(std::make_pair(facts.M, st));
     }
 }
 
 Function *GlobalState::getFuncDef(Function *F)
 {
+    return this->materialize(F);
+}
+
+Function *GlobalState::materialize(Function *F)
+{
+    // another entry may be materializing F, which changes whether it is a declaration
+    lock_guard<mutex> lock(this->materializeMtx);
     if (F->isDeclaration())
     {
-        string name = F->getName().str();
-        auto it = this->name2GlbFuncDef.find(name);
-        if (it != this->name2GlbFuncDef.end())
-        {
-            return it->second;
-        }
-        else
+        auto it = this->name2GlbFuncDef.find(F->getName());
+        if (it == this->name2GlbFuncDef.end())
         {
             // Cannot find definition
             return nullptr;
         }
+        F = it->second;
     }
-    else // already definition
+    if (!F->isMaterializable())
     {
         return F;
     }
+    if (Error err = F->materialize())
+    {
+        this->out << "[-] Cannot materialize " << F->getName().str() << ": " << toString(std::move(err)) << "\n";
+        return nullptr;
+    }
+    return F;
 }
 
-set<Function *> GlobalState::getFuncDefs(string name)
+ArrayRef<Function *> GlobalState::getFuncDefs(StringRef name)
 {
-    set<Function *> defs;
-
-    auto itGlb = this->name2GlbFuncDef.find(name);
-    if (itGlb != this->name2GlbFuncDef.end())
+    auto it = this->name2FuncDefs.find(name);
+    if (it != this->name2FuncDefs.end())
     {
-        defs.insert(itGlb->second);
+        return it->getValue();
     }
+    return ArrayRef<Function *>();
+}
 
-    auto itInternal = this->name2InternalFuncDef.equal_range(name);
-    for (auto it = itInternal.first; it != itInternal.second; ++it)
+Function *GlobalState::getSingleFuncDef(StringRef name)
+{
+    ArrayRef<Function *> defs = this->getFuncDefs(name);
+    if (defs.size() == 1)
     {
-        defs.insert(it->second);
+        Function *def = defs.front();
+        return this->materialize(def);
     }
+    else
+    {
+        throw exception();
+    }
+}
 
-    return defs;
+ArrayRef<Instruction *> GlobalState::getInstsAtSrcLine(Function *F, StringRef filename, uint32_t line)
+{
+    lock_guard<mutex> lock(this->srcLineMtx);
+    SrcLineIndex &index = this->getSrcLineIndex(F);
+    auto itFilename = this->srcFilenames.find(filename);
+    if (itFilename == this->srcFilenames.end())
+    {
+        // no debug location of any indexed function is in this file
+        return ArrayRef<Instruction *>();
+    }
+    auto it = index.find(std::make_pair(itFilename->getKeyData(), line));
+    if (it != index.end())
+    {
+        return it->second;
+    }
+    return ArrayRef<Instruction *>();
 }
 
-Function *GlobalState::getSingleFuncDef(string name)
+SrcLineIndex &GlobalState::getSrcLineIndex(Function *F)
 {
-    set<Function *> defs = this->getFuncDefs(name);
-    if (defs.size() == 1)
+    auto it = this->func2SrcLineIndex.find(F);
+    if (it != this->func2SrcLineIndex.end())
     {
-        return *defs.begin();
+        return it->second;
     }
-    else
+
+    // a lazily loaded body is indexed once it is loaded
+    SrcLineIndex &index = this->func2SrcLineIndex[F];
+    if (!this->materialize(F))
     {
-        throw exception();
+        return index;
+    }
+    for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I)
+    {
+        const DebugLoc &dbgloc = (*I).getDebugLoc();
+        if (dbgloc)
+        {
+            // filenames are interned, so a key is compared by pointer
+            const char *fn = this->srcFilenames.insert(dbgloc->getFilename()).first->getKeyData();
+            index[std::make_pair(fn, dbgloc->getLine())].push_back(&(*I));
+        }
     }
+    return index;
 }
 
 void GlobalState::printTypes()
 {
-    for (auto it = this->name2StructType.begin(); it != this->name2StructType.end(); ++it)
+    // print in name order
+    vector<StringRef> names;
+    for (auto &it : this->name2StructType)
     {
-        this->outTypes << "[type] " << it->first << " [id] " << (uint64_t)it->second.second << " [module] " << it->second.first->getModuleIdentifier() << endl;
+        names.push_back(it.getKey());
+    }
+    std::sort(names.begin(), names.end());
+    for (StringRef name : names)
+    {
+        for (auto &type : this->name2StructType[name])
+        {
+            this->outTypes << "[type] " << name.str() << " [id] " << (uint64_t)type.second << " [module] " << type.first->getModuleIdentifier() << endl;
+        }
     }
 }
 
 void GlobalState::searchTypes(const char *objName)
 {
-    auto range = this->name2StructType.equal_range(objName);
     int cnt = 0;
-    for (auto it = range.first; it != range.second; ++it)
+    auto it = this->name2StructType.find(objName);
+    if (it != this->name2StructType.end())
     {
-        this->outTypes << "[type] " << it->first << " [id] " << (uint64_t)it->second.second << " [module] " << it->second.first->getModuleIdentifier() << endl;
-        cnt++;
+        for (auto &type : it->getValue())
+        {
+            this->outTypes << "[type] " << objName << " [id] " << (uint64_t)type.second << " [module] " << type.first->getModuleIdentifier() << endl;
+            cnt++;
+        }
     }
     cout << objName << ": number is " << cnt << endl;
 }
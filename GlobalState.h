@@ -1,12 +1,35 @@
 #pragma once
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/IR/Module.h"
 
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <set>
+#include <string>
 #include <vector>
 
+// Symbol facts of one module, extracted by the thread that parsed it
+class ModuleFacts
+{
+public:
+    uint32_t moduleIdx; // position in the input list
+    llvm::Module *M;
+    std::vector<llvm::Function *> funcDefs; // external, internal and weak definitions
+    std::vector<llvm::StructType *> structTypes; // named, non-opaque struct types
+
+    ModuleFacts(uint32_t moduleIdx, llvm::Module &M);
+};
+
+typedef std::vector<ModuleFacts> SymbolShard; // facts of all modules parsed by one thread
+typedef llvm::DenseMap<std::pair<const char *, uint32_t>, llvm::SmallVector<llvm::Instruction *, 2>> SrcLineIndex; // (interned filename, line) -> instructions of one function
+
 class GlobalState
 {
 public:
@@ -14,21 +37,33 @@ public:
     std::ofstream outFunctions; // output function info
     std::ofstream outTypes; // output type info
     std::vector<llvm::Module *> moduleList;
-    std::map<std::string, llvm::Function *> name2GlbFuncDef;
-    std::multimap<std::string, llvm::Function *> name2InternalFuncDef;
-    std::map<std::string, llvm::Function *> name2WeakGlbFuncDef;
-    std::multimap<std::string, std::pair<llvm::Module *, llvm::StructType *>> name2StructType;
+    // symbol tables are hashed on names, which are stored once in each table
+    llvm::StringMap<llvm::Function *> name2GlbFuncDef;
+    llvm::StringMap<llvm::SmallVector<llvm::Function *, 1>> name2InternalFuncDef;
+    llvm::StringMap<llvm::Function *> name2WeakGlbFuncDef;
+    llvm::StringMap<llvm::SmallVector<llvm::Function *, 1>> name2FuncDefs; // global definition followed by internal ones
+    llvm::StringMap<llvm::SmallVector<std::pair<llvm::Module *, llvm::StructType *>, 1>> name2StructType;
 
     GlobalState(std::vector<llvm::Module *> MList, std::ostream& out);
+    GlobalState(std::vector<std::string> inputFilenames, std::ostream& out, uint32_t numThreads, bool lazyLoad); // parse and extract facts in the same threads
     std::vector<llvm::Module *> &getModuleList();
-    llvm::Function *getFuncDef(llvm::Function *);
-    std::set<llvm::Function *> getFuncDefs(std::string name); // TODO: use caller's filename to filter
-    llvm::Function *getSingleFuncDef(std::string name); // TODO: use caller's filename to filter
+    llvm::Function *getFuncDef(llvm::Function *); // materializes the body of a lazily loaded definition
+    llvm::ArrayRef<llvm::Function *> getFuncDefs(llvm::StringRef name); // TODO: use caller's filename to filter
+    llvm::Function *getSingleFuncDef(llvm::StringRef name); // TODO: use caller's filename to filter
+    llvm::ArrayRef<llvm::Instruction *> getInstsAtSrcLine(llvm::Function *F, llvm::StringRef filename, uint32_t line); // indexes F on first use. Thread-safe
 
     // debug
     void printTypes(); // print types
     void searchTypes(const char *objName); // print types
 
 private:
-    void genModuleFacts(llvm::Module &M); // called in constructor
+    void mergeShards(std::vector<SymbolShard> &shards, uint32_t numModules); // called in constructor
+    void addModuleFacts(ModuleFacts &facts); // called by mergeShards
+    llvm::Function *materialize(llvm::Function *F); // the definition of F with its body loaded, or null. Thread-safe
+    SrcLineIndex &getSrcLineIndex(llvm::Function *F); // build the index of F if it is not built yet. Needs srcLineMtx
+
+    llvm::StringSet<> srcFilenames; // interned filenames of debug locations
+    llvm::DenseMap<llvm::Function *, SrcLineIndex> func2SrcLineIndex;
+    std::mutex materializeMtx; // entries are analyzed in parallel
+    std::mutex srcLineMtx; // guards srcFilenames and func2SrcLineIndex
 };
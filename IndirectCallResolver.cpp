@@ -0,0 +1,137 @@
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/IR/DerivedTypes.h"
+
+#include "IndirectCallResolver.h"
+#include "ParseIR.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+using namespace llvm;
+using namespace std;
+
+uint64_t IndirectCallResolver::hashType(Type *type)
+{
+    unsigned typeId = type->getTypeID();
+    if (StructType *st = dyn_cast<StructType>(type))
+    {
+        if (st->hasName())
+        {
+            return hash_combine(typeId, trimName(st->getName().str())); // struct.sock.123 and struct.sock are the same type
+        }
+        hash_code res = hash_value(typeId);
+        for (Type *elementType : st->elements())
+        {
+            res = hash_combine(res, IndirectCallResolver::hashType(elementType));
+        }
+        return res;
+    }
+    else if (PointerType *pt = dyn_cast<PointerType>(type))
+    {
+        if (pt->isOpaque())
+        {
+            return hash_combine(typeId, pt->getAddressSpace());
+        }
+        return hash_combine(typeId, pt->getAddressSpace(), IndirectCallResolver::hashType(pt->getPointerElementType()));
+    }
+    else if (FunctionType *ft = dyn_cast<FunctionType>(type))
+    {
+        hash_code res = hash_combine(typeId, ft->isVarArg(), IndirectCallResolver::hashType(ft->getReturnType()));
+        for (Type *paramType : ft->params())
+        {
+            res = hash_combine(res, IndirectCallResolver::hashType(paramType));
+        }
+        return res;
+    }
+    else if (ArrayType *at = dyn_cast<ArrayType>(type))
+    {
+        return hash_combine(typeId, at->getNumElements(), IndirectCallResolver::hashType(at->getElementType()));
+    }
+    else if (FixedVectorType *vt = dyn_cast<FixedVectorType>(type))
+    {
+        return hash_combine(typeId, vt->getNumElements(), IndirectCallResolver::hashType(vt->getElementType()));
+    }
+    else if (IntegerType *it = dyn_cast<IntegerType>(type))
+    {
+        return hash_combine(typeId, it->getBitWidth());
+    }
+    return hash_value(typeId);
+}
+
+// collect (type hash, function) of the address-taken functions of each module.
+// Bodies that are not materialized yet are not scanned, but function pointers in global initializers are
+static void collectWork(vector<Module *> &moduleList, vector<vector<pair<uint64_t, Function *>>> &res, atomic<uint32_t> &next)
+{
+    for (uint32_t i = next++; i < moduleList.size(); i = next++)
+    {
+        for (Function &F : *moduleList[i])
+        {
+            if (!F.isIntrinsic() && F.hasAddressTaken(nullptr, false, true, true))
+            {
+                res[i].push_back(std::make_pair(IndirectCallResolver::hashType(F.getFunctionType()), &F));
+            }
+        }
+    }
+}
+
+IndirectCallResolver::IndirectCallResolver(GlobalState &glbState, uint32_t numThreads)
+{
+    vector<Module *> &moduleList = glbState.getModuleList();
+    vector<vector<pair<uint64_t, Function *>>> funcsOfModule(moduleList.size());
+    numThreads = std::min(getNumThreads(numThreads), std::max((uint32_t)moduleList.size(), 1u));
+    atomic<uint32_t> next(0);
+    vector<thread> threads(numThreads);
+    for (uint32_t t = 0; t < numThreads; ++t)
+    {
+        threads[t] = thread(collectWork, std::ref(moduleList), std::ref(funcsOfModule), std::ref(next));
+    }
+    for (uint32_t t = 0; t < numThreads; ++t)
+    {
+        threads[t].join();
+    }
+
+    // merge in module order. A global function is represented by its definition, so that it appears once
+    DenseSet<Function *> added;
+    for (vector<pair<uint64_t, Function *>> &funcs : funcsOfModule)
+    {
+        for (pair<uint64_t, Function *> &each : funcs)
+        {
+            Function *F = each.second;
+            if (!F->hasLocalLinkage())
+            {
+                auto it = glbState.name2GlbFuncDef.find(F->getName());
+                if (it != glbState.name2GlbFuncDef.end())
+                {
+                    F = it->second;
+                }
+            }
+            if (added.insert(F).second)
+            {
+                this->hash2Funcs[each.first].push_back(F);
+            }
+        }
+    }
+}
+
+ArrayRef<Function *> IndirectCallResolver::getCallees(CallInst &callInst) const
+{
+    auto it = this->hash2Funcs.find(IndirectCallResolver::hashType(callInst.getFunctionType()));
+    if (it != this->hash2Funcs.end())
+    {
+        return it->second;
+    }
+    return ArrayRef<Function *>();
+}
+
+uint64_t IndirectCallResolver::getNumFuncs() const
+{
+    uint64_t res = 0;
+    for (auto &it : this->hash2Funcs)
+    {
+        res += it.second.size();
+    }
+    return res;
+}
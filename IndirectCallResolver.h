@@ -0,0 +1,27 @@
+#pragma once
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/Instructions.h"
+
+#include "GlobalState.h"
+
+#include <vector>
+
+// Resolves indirect calls to the address-taken functions whose type matches the type of the call.
+// Types of different modules live in different LLVMContexts, so they are compared by a structural hash
+// in which named structs are represented by their names without the numeric suffix
+class IndirectCallResolver
+{
+public:
+    IndirectCallResolver(GlobalState &glbState, uint32_t numThreads); // scan all modules of glbState in parallel
+
+    // candidate callees of an indirect call; they may be declarations, like the entries of the call graph
+    llvm::ArrayRef<llvm::Function *> getCallees(llvm::CallInst &callInst) const;
+    uint64_t getNumFuncs() const;
+
+    static uint64_t hashType(llvm::Type *type);
+
+private:
+    llvm::DenseMap<uint64_t, std::vector<llvm::Function *>> hash2Funcs; // type hash -> address-taken functions
+};
@@ -1,4 +1,4 @@
-#include "llvm/Analysis/CFG.h"
+#include "llvm/IR/CFG.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include "InstLoc.h"
@@ -8,65 +8,134 @@
 using namespace llvm;
 using namespace std;
 
-Context::Context(Function *entry) : entry(entry)
+ContextNode::ContextNode(ContextId parent, CallInst *callInst, Function *func, Function *entry, uint32_t depth) : parent(parent), callInst(callInst), func(func), entry(entry), depth(depth)
 {
 }
 
-bool Context::operator<(const Context &rhs) const
+std::mutex ContextManager::mtx;
+vector<vector<ContextNode>> ContextManager::shardNodes(1);
+DenseMap<Function *, ContextId> ContextManager::entry2Root;
+DenseMap<tuple<ContextId, CallInst *, Function *>, ContextId> ContextManager::call2Child;
+
+void ContextManager::setNumShards(uint32_t numShards)
 {
-    if (this->entry == rhs.entry)
-    {
-        return this->pairs < rhs.pairs;
-    }
-    else
+    lock_guard<std::mutex> lock(mtx);
+    if (numShards > shardNodes.size())
     {
-        return this->entry < rhs.entry;
+        shardNodes.resize(numShards);
     }
 }
 
-Function *Context::getCurrentFunction() const
+ContextId ContextManager::getOrCreateRoot(Function *entry)
 {
-    if (this->pairs.size() == 0)
+    lock_guard<std::mutex> lock(mtx);
+    auto it = entry2Root.find(entry);
+    if (it != entry2Root.end())
     {
-        return entry;
+        return it->second;
     }
-    else
+    ShardId shard = ShardManager::getCurrentShard();
+    assert(shard < shardNodes.size());
+    ContextId id = ShardManager::makeId(shard, shardNodes[shard].size());
+    shardNodes[shard].push_back(ContextNode(id, nullptr, entry, entry, 1));
+    entry2Root[entry] = id;
+    return id;
+}
+
+ContextId ContextManager::getOrCreateChild(ContextId parent, CallInst *callInst, Function *calledFunc)
+{
+    lock_guard<std::mutex> lock(mtx);
+    auto key = std::make_tuple(parent, callInst, calledFunc);
+    auto it = call2Child.find(key);
+    if (it != call2Child.end())
     {
-        return this->pairs.back().second;
+        return it->second;
     }
+    ShardId shard = ShardManager::getCurrentShard();
+    assert(shard < shardNodes.size());
+    ContextId id = ShardManager::makeId(shard, shardNodes[shard].size());
+    const ContextNode &parentNode = getNode(parent);
+    shardNodes[shard].push_back(ContextNode(parent, callInst, calledFunc, parentNode.entry, parentNode.depth + 1));
+    call2Child[key] = id;
+    return id;
 }
 
-InstLoc Context::getCallerInstLoc() const
+const ContextNode &ContextManager::getNode(ContextId id)
+{
+    return shardNodes[ShardManager::getShard(id)][ShardManager::getIdx(id)];
+}
+
+Context::Context(Function *entry) : id(ContextManager::getOrCreateRoot(entry))
+{
+}
+
+Context::Context(ContextId id) : id(id)
+{
+}
+
+bool Context::operator<(const Context &rhs) const
 {
-    assert(this->pairs.size() >= 1);
-    CallInst *inst = this->pairs.back().first;
+    return this->id < rhs.id;
+}
 
-    Context res(*this);
-    res.pairs.pop_back();
-    return InstLoc(res, inst);
+bool Context::operator==(const Context &rhs) const
+{
+    return this->id == rhs.id;
+}
+
+bool Context::operator!=(const Context &rhs) const
+{
+    return this->id != rhs.id;
+}
+
+Function *Context::getEntry() const
+{
+    return ContextManager::getNode(this->id).entry;
+}
+
+Function *Context::getCurrentFunction() const
+{
+    return ContextManager::getNode(this->id).func;
+}
+
+InstLoc Context::getCallerInstLoc() const
+{
+    const ContextNode &node = ContextManager::getNode(this->id);
+    assert(node.callInst);
+    return InstLoc(Context(node.parent), node.callInst);
 }
 
 uint32_t Context::getDepth() const
 {
-    return this->pairs.size() + 1;
+    return ContextManager::getNode(this->id).depth;
 }
 
 Context Context::add(CallInst *callInst, Function *calledFunc) const
 {
-    Context res(*this);
-    res.pairs.push_back(std::pair<CallInst *, Function *>(callInst, calledFunc));
-    return res;
+    return Context(ContextManager::getOrCreateChild(this->id, callInst, calledFunc));
 }
 
 string Context::toString() const
 {
+    // for simplicity, only print called functions
+    vector<Function *> funcs;
+    for (ContextId id = this->id;; id = ContextManager::getNode(id).parent)
+    {
+        const ContextNode &node = ContextManager::getNode(id);
+        funcs.push_back(node.func);
+        if (!node.callInst)
+        {
+            break;
+        }
+    }
     string res;
-    res += entry->getName().str();
-    for (auto &pair : this->pairs)
+    for (auto it = funcs.rbegin(); it != funcs.rend(); ++it)
     {
-        // for simplicity, only print called function
-        res += ":";
-        res += pair.second->getName().str();
+        if (it != funcs.rbegin())
+        {
+            res += ":";
+        }
+        res += (*it)->getName().str();
     }
     return res;
 }
@@ -89,31 +158,203 @@ string InstLoc::toString() const
     return res;
 }
 
-bool isReachable(InstLoc fromLoc, InstLoc toLoc)
+BBReachability::BBReachability(Function *F)
 {
-    // Different entries, unreachable
-    if (fromLoc.context.entry != toLoc.context.entry)
+    uint32_t pos = 0;
+    for (BasicBlock &BB : *F)
     {
-        return false;
+        this->bb2Idx[&BB] = this->bbs.size();
+        this->bbs.push_back(&BB);
+        for (Instruction &I : BB)
+        {
+            this->inst2Pos[&I] = pos++;
+        }
+    }
+    this->succReachable.resize(this->bbs.size());
+    this->computed.resize(this->bbs.size(), false);
+}
+
+bool BBReachability::isReachableThroughEdges(BasicBlock *from, BasicBlock *to)
+{
+    uint32_t fromIdx = this->bb2Idx[from];
+    if (!this->computed[fromIdx])
+    {
+        // DFS from the successors of from
+        BitVector &reachable = this->succReachable[fromIdx];
+        reachable.resize(this->bbs.size());
+        vector<BasicBlock *> worklist(succ_begin(from), succ_end(from));
+        while (!worklist.empty())
+        {
+            BasicBlock *BB = worklist.back();
+            worklist.pop_back();
+            uint32_t idx = this->bb2Idx[BB];
+            if (reachable.test(idx))
+            {
+                continue;
+            }
+            reachable.set(idx);
+            worklist.insert(worklist.end(), succ_begin(BB), succ_end(BB));
+        }
+        this->computed[fromIdx] = true;
+    }
+    return this->succReachable[fromIdx].test(this->bb2Idx[to]);
+}
+
+bool BBReachability::comesBefore(Instruction *from, Instruction *to)
+{
+    assert(from->getParent() == to->getParent());
+    return this->inst2Pos.lookup(from) < this->inst2Pos.lookup(to);
+}
+
+thread_local DenseMap<Function *, unique_ptr<BBReachability>> ReachabilityManager::func2BBReachability;
+thread_local DenseMap<pair<ContextId, ContextId>, ContextReachQuery> ReachabilityManager::contextPair2Query;
+thread_local DenseMap<Function *, unique_ptr<DominatorTree>> ReachabilityManager::func2DomTree;
+
+BBReachability &ReachabilityManager::getBBReachability(Function *F)
+{
+    unique_ptr<BBReachability> &bbReachability = func2BBReachability[F];
+    if (!bbReachability)
+    {
+        bbReachability.reset(new BBReachability(F));
+    }
+    return *bbReachability;
+}
+
+bool ReachabilityManager::isPotentiallyReachable(Instruction *from, Instruction *to)
+{
+    BasicBlock *fromBB = from->getParent();
+    BasicBlock *toBB = to->getParent();
+    Function *F = fromBB->getParent();
+    assert(F == toBB->getParent());
+    BBReachability &bbReachability = getBBReachability(F);
+    if (fromBB == toBB && (from == to || bbReachability.comesBefore(from, to)))
+    {
+        return true;
+    }
+    return bbReachability.isReachableThroughEdges(fromBB, toBB); // from after to in the same block needs a cycle
+}
+
+bool ReachabilityManager::dominates(Instruction *from, Instruction *to)
+{
+    Function *F = from->getFunction();
+    assert(F == to->getFunction());
+    unique_ptr<DominatorTree> &domTree = func2DomTree[F];
+    if (!domTree)
+    {
+        domTree.reset(new DominatorTree(*F));
+    }
+    BasicBlock *BB = from->getParent();
+    if (BB != to->getParent() || isa<InvokeInst>(from) || isa<CallBrInst>(from) || isa<PHINode>(to))
+    {
+        return domTree->dominates(from, to); // decided by the blocks
     }
+    // same as DominatorTree::dominates, with the order of this thread instead of Instruction::comesBefore
+    if (!domTree->isReachableFromEntry(BB))
+    {
+        return true;
+    }
+    return from != to && getBBReachability(F).comesBefore(from, to);
+}
 
-    size_t minPairsSize = min(fromLoc.context.pairs.size(), toLoc.context.pairs.size());
-    for (size_t i = 0; i < minPairsSize; ++i)
+bool ReachabilityManager::isInCycle(Instruction *inst)
+{
+    BasicBlock *BB = inst->getParent();
+    return getBBReachability(BB->getParent()).isReachableThroughEdges(BB, BB);
+}
+
+ContextReachQuery ReachabilityManager::getContextReachQuery(ContextId from, ContextId to)
+{
+    auto it = contextPair2Query.find(std::make_pair(from, to));
+    if (it != contextPair2Query.end())
     {
-        if (fromLoc.context.pairs[i].first != toLoc.context.pairs[i].first)
+        return it->second;
+    }
+
+    ContextReachQuery res;
+    res.unreachable = false;
+    res.fromInst = nullptr;
+    res.toInst = nullptr;
+    if (ContextManager::getNode(from).entry != ContextManager::getNode(to).entry)
+    {
+        res.unreachable = true; // Different entries, unreachable
+    }
+    else
+    {
+        // lift the deeper location to the call site at the depth of the other one
+        ContextId currFrom = from, currTo = to;
+        while (ContextManager::getNode(currFrom).depth > ContextManager::getNode(currTo).depth)
+        {
+            res.fromInst = ContextManager::getNode(currFrom).callInst;
+            currFrom = ContextManager::getNode(currFrom).parent;
+        }
+        while (ContextManager::getNode(currTo).depth > ContextManager::getNode(currFrom).depth)
         {
-            return isPotentiallyReachable(fromLoc.context.pairs[i].first, toLoc.context.pairs[i].first);
+            res.toInst = ContextManager::getNode(currTo).callInst;
+            currTo = ContextManager::getNode(currTo).parent;
         }
-        else
+
+        // find the first call where the contexts diverge, right below their common ancestor
+        if (currFrom != currTo)
         {
-            if (fromLoc.context.pairs[i].second != toLoc.context.pairs[i].second)
+            while (ContextManager::getNode(currFrom).parent != ContextManager::getNode(currTo).parent)
             {
-                return false; // same caller but different called functions, unreachable
+                currFrom = ContextManager::getNode(currFrom).parent;
+                currTo = ContextManager::getNode(currTo).parent;
             }
+            res.fromInst = ContextManager::getNode(currFrom).callInst;
+            res.toInst = ContextManager::getNode(currTo).callInst;
+            res.unreachable = res.fromInst == res.toInst; // same caller but different called functions, unreachable
         }
     }
+    contextPair2Query[std::make_pair(from, to)] = res;
+    return res;
+}
 
-    Instruction *tmpFrom = (fromLoc.context.pairs.size() <= minPairsSize) ? fromLoc.inst : fromLoc.context.pairs[minPairsSize].first;
-    Instruction *tmpTo = (toLoc.context.pairs.size() <= minPairsSize) ? toLoc.inst : toLoc.context.pairs[minPairsSize].first;
-    return isPotentiallyReachable(tmpFrom, tmpTo);
+bool isReachable(InstLoc fromLoc, InstLoc toLoc)
+{
+    ContextReachQuery query = ReachabilityManager::getContextReachQuery(fromLoc.context.id, toLoc.context.id);
+    if (query.unreachable)
+    {
+        return false;
+    }
+    Instruction *fromInst = query.fromInst ? query.fromInst : fromLoc.inst;
+    Instruction *toInst = query.toInst ? query.toInst : toLoc.inst;
+    return ReachabilityManager::isPotentiallyReachable(fromInst, toInst);
+}
+
+bool dominates(InstLoc fromLoc, InstLoc toLoc)
+{
+    // reduce toLoc to the call of the function of fromLoc, which must be on its context
+    ContextId to = toLoc.context.id;
+    Instruction *toInst = toLoc.inst;
+    while (ContextManager::getNode(to).depth > fromLoc.context.getDepth())
+    {
+        toInst = ContextManager::getNode(to).callInst;
+        to = ContextManager::getNode(to).parent;
+    }
+    if (to != fromLoc.context.id)
+    {
+        return false;
+    }
+    return ReachabilityManager::dominates(fromLoc.inst, toInst);
+}
+
+bool isInCycle(InstLoc loc)
+{
+    ContextId id = loc.context.id;
+    Instruction *inst = loc.inst;
+    while (true)
+    {
+        if (ReachabilityManager::isInCycle(inst))
+        {
+            return true;
+        }
+        const ContextNode &node = ContextManager::getNode(id);
+        if (!node.callInst)
+        {
+            return false;
+        }
+        inst = node.callInst;
+        id = node.parent;
+    }
 }
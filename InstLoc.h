@@ -1,19 +1,64 @@
 #pragma once
 
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/IR/Instructions.h"
 
+#include <memory>
+#include <mutex>
+#include <tuple>
 #include <vector>
 
+#include "Shard.h"
+
 class InstLoc;
 
-class Context
+typedef uint64_t ContextId; // (shard, index in shard)
+
+// A node of the context tree. A root is an entry function; any other node extends its parent by a call
+class ContextNode
 {
 public:
+    ContextId parent; // the node itself for a root
+    llvm::CallInst *callInst; // null for a root
+    llvm::Function *func; // the entry for a root, the called function otherwise
     llvm::Function *entry;
-    std::vector<std::pair<llvm::CallInst *, llvm::Function *>> pairs;
+    uint32_t depth; // 1 for a root
+
+    ContextNode(ContextId parent, llvm::CallInst *callInst, llvm::Function *func, llvm::Function *entry, uint32_t depth);
+};
+
+// Interns all contexts as a tree, so that equal contexts have the same ContextId.
+// A new node goes to the shard of the calling thread. Nodes are read without locking, so each shard must be
+// extended only by its own thread, and the shards must exist before other threads start
+class ContextManager
+{
+public:
+    static void setNumShards(uint32_t numShards);
+    static ContextId getOrCreateRoot(llvm::Function *entry);
+    static ContextId getOrCreateChild(ContextId parent, llvm::CallInst *callInst, llvm::Function *calledFunc);
+    static const ContextNode &getNode(ContextId id);
+
+private:
+    static std::mutex mtx; // guards the creation of nodes
+    static std::vector<std::vector<ContextNode>> shardNodes; // indexed by ShardId, then by index in shard
+    static llvm::DenseMap<llvm::Function *, ContextId> entry2Root;
+    static llvm::DenseMap<std::tuple<ContextId, llvm::CallInst *, llvm::Function *>, ContextId> call2Child;
+};
+
+// A call string from an entry, represented by the ContextId of its interned node
+class Context
+{
+public:
+    ContextId id;
 
     Context(llvm::Function *entry); // construct Context from entry
-    bool operator<(const Context &rhs) const; // for std::map
+    explicit Context(ContextId id);
+    bool operator<(const Context &rhs) const; // for std::map. Orders by creation, not lexicographically
+    bool operator==(const Context &rhs) const;
+    bool operator!=(const Context &rhs) const;
+    llvm::Function *getEntry() const;
     llvm::Function *getCurrentFunction() const;
     InstLoc getCallerInstLoc() const;
     uint32_t getDepth() const;
@@ -31,4 +76,48 @@ public:
     std::string toString() const;
 };
 
+// Reachability between the basic blocks of a function, computed once per source block and cached.
+// Also numbers the instructions, since Instruction::comesBefore renumbers the shared block
+class BBReachability
+{
+public:
+    std::vector<llvm::BasicBlock *> bbs;
+    llvm::DenseMap<llvm::BasicBlock *, uint32_t> bb2Idx;
+    std::vector<llvm::BitVector> succReachable; // blocks reachable through at least one edge, empty if not computed yet
+    std::vector<bool> computed;
+    llvm::DenseMap<llvm::Instruction *, uint32_t> inst2Pos; // position in the function
+
+    BBReachability(llvm::Function *F);
+    bool isReachableThroughEdges(llvm::BasicBlock *from, llvm::BasicBlock *to);
+    bool comesBefore(llvm::Instruction *from, llvm::Instruction *to); // both in the same block
+};
+
+// The pair of instructions that decides the reachability between two contexts
+class ContextReachQuery
+{
+public:
+    bool unreachable; // the contexts exclude each other
+    llvm::Instruction *fromInst; // null means the instruction of the from location
+    llvm::Instruction *toInst; // null means the instruction of the to location
+};
+
+// Caches are per thread, so that the analyses of different entries can run in parallel
+class ReachabilityManager
+{
+public:
+    // same as llvm::isPotentiallyReachable without DominatorTree and LoopInfo, but exact for any CFG size
+    static bool isPotentiallyReachable(llvm::Instruction *from, llvm::Instruction *to);
+    static ContextReachQuery getContextReachQuery(ContextId from, ContextId to);
+    static bool dominates(llvm::Instruction *from, llvm::Instruction *to); // both in the same function
+    static bool isInCycle(llvm::Instruction *inst); // whether the block of inst can reach itself
+
+private:
+    static BBReachability &getBBReachability(llvm::Function *F);
+    static thread_local llvm::DenseMap<llvm::Function *, std::unique_ptr<BBReachability>> func2BBReachability;
+    static thread_local llvm::DenseMap<llvm::Function *, std::unique_ptr<llvm::DominatorTree>> func2DomTree;
+    static thread_local llvm::DenseMap<std::pair<ContextId, ContextId>, ContextReachQuery> contextPair2Query;
+};
+
 bool isReachable(InstLoc fromLoc, InstLoc toLoc);
+bool dominates(InstLoc fromLoc, InstLoc toLoc); // every execution of toLoc is preceded by fromLoc in the same call of its function
+bool isInCycle(InstLoc loc); // the instruction or a call site on its context is in a CFG cycle
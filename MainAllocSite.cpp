@@ -11,8 +11,7 @@ int main(int argc, char **argv)
 {
     vector<string> inputFilenames = parseInput("input");
     std::ostream out(0);
-    vector<Module *> moduleList = parseIRFilesMultithread(inputFilenames, out);
-    GlobalState glbState(moduleList, out);
+    GlobalState glbState(inputFilenames, out, 0, false);
 
     multimap<StructType *, CallInst *> rets[2]; // rets[0] is general, rets[1] is special
     string outputPrefixes[2] {"[general] ", "[special] "};
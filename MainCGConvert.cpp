@@ -0,0 +1,17 @@
+#include "llvm/Support/CommandLine.h"
+
+#include "BinaryCG.h"
+
+#include <iostream>
+
+using namespace llvm;
+using namespace std;
+
+cl::opt<string> textCG(cl::Positional, cl::desc("<text call graph>"), cl::Required);
+cl::opt<string> binaryCG(cl::Positional, cl::desc("<binary call graph>"), cl::Required);
+
+int main(int argc, char **argv)
+{
+    cl::ParseCommandLineOptions(argc, argv, "convert a caller->callee call graph into the binary format\n");
+    return BinaryCG::convertText(textCG, binaryCG, cout) ? 0 : 1;
+}
@@ -2,18 +2,25 @@
 #include "llvm/IR/Module.h"
 #include "llvm/Support/CommandLine.h"
 
+#include "BinaryCG.h"
 #include "CallGraph.h"
 #include "Config.h"
 #include "DDG.h"
+#include "FunctionSummary.h"
 #include "GlobalState.h"
+#include "IndirectCallResolver.h"
 #include "ParseIR.h"
+#include "SymbolIndex.h"
 #include "Utils.h"
 #include "Visitor.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
 #include <fstream>
+#include <memory>
+#include <thread>
 
 using namespace llvm;
 using namespace std;
@@ -33,6 +40,49 @@ vector<Function *> getEntryFuncs(GlobalState &glbState, vector<string> entryFunc
     return entryFuncs;
 }
 
+// the analysis of one entry function, into its own records and shard
+class EntryJob
+{
+public:
+    Function *entryFunc;
+    PointsToRecords ptoRecords;
+    DDG ddg;
+    unique_ptr<FunctionSummaryCache> summaryCache;
+    long long time; // ms
+#ifdef NUM_VISITED_BBS
+    uint64_t numVisitedBBs;
+#endif
+
+    EntryJob(Function *entryFunc, const ObjectManager &objMgr);
+};
+
+EntryJob::EntryJob(Function *entryFunc, const ObjectManager &objMgr) : entryFunc(entryFunc), ddg(objMgr), time(0)
+#ifdef NUM_VISITED_BBS
+, numVisitedBBs(0)
+#endif
+{
+}
+
+static void analyzeWork(GlobalState &glbState, IndirectCallGraph &callGraph, const IndirectCallResolver *indirectCallResolver, ObjectManager &objMgr, vector<unique_ptr<EntryJob>> &jobs, atomic<uint32_t> &next)
+{
+    for (uint32_t i = next++; i < jobs.size(); i = next++)
+    {
+        EntryJob &job = *jobs[i];
+        ShardManager::setCurrentShard(i + 1);
+        Context context(job.entryFunc);
+        FunctionVisitor vis(glbState, context, callGraph, indirectCallResolver, job.summaryCache.get(), objMgr, job.ptoRecords, job.ddg);
+
+        chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+        vis.analyze();
+        chrono::steady_clock::time_point end = chrono::steady_clock::now();
+        job.time = std::chrono::duration_cast<chrono::milliseconds>(end - begin).count();
+#ifdef NUM_VISITED_BBS
+        job.numVisitedBBs = vis.getNumVisitedBBs();
+#endif
+    }
+    ShardManager::setCurrentShard(0);
+}
+
 int main(int argc, char **argv)
 {
     cl::ParseCommandLineOptions(argc, argv);
@@ -43,19 +93,65 @@ int main(int argc, char **argv)
     vector<string> inputFilenames;
     string callGraph;
     bool doPrint;
-    parseConfigFile(config, entryFuncNames, initMemErrs, inputFilenames, maxCallDepth, callGraph, doPrint);
+    uint32_t numThreads;
+    bool lazyLoad;
+    string symbolIndex;
+    bool resolveIndirectCalls;
+    bool summarizeCalls;
+    DummyGranularity dummyGranularity;
+    parseConfigFile(config, entryFuncNames, initMemErrs, inputFilenames, maxCallDepth, callGraph, doPrint, numThreads, lazyLoad, symbolIndex, resolveIndirectCalls, summarizeCalls, dummyGranularity);
+
+    // read call graph. A binary call graph is used in place
+    DSimpleCGMap dSimpleCGMap;
+    unique_ptr<BinaryCG> binaryCG;
+    if (BinaryCG::isBinaryCGFile(callGraph))
+    {
+        binaryCG.reset(new BinaryCG(callGraph));
+        if (!binaryCG->isValid())
+        {
+            outs() << "[-] Invalid binary call graph " << callGraph << "; convert it again with CGConvert\n";
+            return 1;
+        }
+    }
+    else
+    {
+        dSimpleCGMap = DSimpleCGSet2DSimpleCGMap(readDSimpleCGSet(callGraph));
+    }
 
-    // parse all input IR files
     ofstream parseOut("out_parse"); // output all parsing related info to this file
     assert(parseOut.is_open());
-    vector<Module *> moduleList = parseIRFilesMultithread(inputFilenames, parseOut);
-    GlobalState glbState(moduleList, parseOut);
+
+    // only keep the input files reachable from the entries and the call traces
+    if (!symbolIndex.empty())
+    {
+        SymbolIndex index(symbolIndex, inputFilenames, numThreads, parseOut);
+        vector<string> rootFuncs = entryFuncNames;
+        uint32_t requiredDepth = maxCallDepth;
+        for (InitMemErr &initMemErr : initMemErrs)
+        {
+            for (CallTraceItem &item : initMemErr.callTrace)
+            {
+                rootFuncs.push_back(item.func);
+            }
+            requiredDepth = std::max(requiredDepth, (uint32_t)initMemErr.callTrace.size());
+        }
+        inputFilenames = binaryCG ? index.getRequiredFiles(rootFuncs, *binaryCG, requiredDepth, resolveIndirectCalls) : index.getRequiredFiles(rootFuncs, dSimpleCGMap, requiredDepth, resolveIndirectCalls);
+    }
+
+    // parse all input IR files
+    GlobalState glbState(inputFilenames, parseOut, numThreads, lazyLoad);
     parseOut.close();
 
-    // read call graph
-    DSimpleCGSet dSimpleCGSet = readDSimpleCGSet(callGraph);
-    DSimpleCGMap dSimpleCGMap = DSimpleCGSet2DSimpleCGMap(dSimpleCGSet);
-    CGMap cgMap = DSimpleCGMap2CGMap(glbState, dSimpleCGMap);
+    // import call graph. The callsites of a caller are located once the analysis reaches it
+    unique_ptr<IndirectCallGraph> indirectCG(binaryCG ? new IndirectCallGraph(glbState, *binaryCG) : new IndirectCallGraph(glbState, dSimpleCGMap));
+
+    // type-based resolution of the indirect calls missing in the call graph
+    unique_ptr<IndirectCallResolver> indirectCallResolver;
+    if (resolveIndirectCalls)
+    {
+        indirectCallResolver.reset(new IndirectCallResolver(glbState, numThreads));
+        outs() << "[*] " << indirectCallResolver->getNumFuncs() << " address-taken functions for indirect calls\n";
+    }
 
     // entries
     vector<Function *> entryFuncs;
@@ -63,47 +159,86 @@ int main(int argc, char **argv)
     for (InitMemErr initMemErr : initMemErrs)
     {
         // context of init memory error. Also update indirect call graph
-        Context initMemErrCtx = callTrace2Context(glbState, initMemErr.callTrace, cgMap);
+        Context initMemErrCtx = callTrace2Context(glbState, initMemErr.callTrace, *indirectCG);
         initMemErrCtxs.push_back(initMemErrCtx);
 
         // add init memory error entry
-        if (std::find(entryFuncs.begin(), entryFuncs.end(), initMemErrCtx.entry) == entryFuncs.end())
+        if (std::find(entryFuncs.begin(), entryFuncs.end(), initMemErrCtx.getEntry()) == entryFuncs.end())
         {
-            entryFuncs.push_back(initMemErrCtx.entry);
+            entryFuncs.push_back(initMemErrCtx.getEntry());
         }
 
         maxCallDepth = std::max(maxCallDepth, initMemErrCtx.getDepth()); // should at least allow us to reach the bug site. TODO: use different call depths
     }
     vector<Function *> otherEntries = getEntryFuncs(glbState, entryFuncNames); // other entries
-    entryFuncs.insert(entryFuncs.end(), otherEntries.begin(), otherEntries.end());
+    for (Function *entryFunc : otherEntries)
+    {
+        if (std::find(entryFuncs.begin(), entryFuncs.end(), entryFunc) == entryFuncs.end()) // an entry is analyzed once
+        {
+            entryFuncs.push_back(entryFunc);
+        }
+    }
+
+    // analyze each entry function in parallel. Entries only share global objects, so each is analyzed into its own
+    // records, which are merged in entry order
+    ContextManager::setNumShards(entryFuncs.size() + 1);
+    ObjectManager objMgr(glbState.getModuleList(), entryFuncs.size() + 1, dummyGranularity);
+    vector<unique_ptr<EntryJob>> jobs;
+    for (Function *entryFunc : entryFuncs)
+    {
+        unique_ptr<EntryJob> job(new EntryJob(entryFunc, objMgr));
+        if (summarizeCalls)
+        {
+            job->summaryCache.reset(new FunctionSummaryCache(job->ptoRecords, job->ddg));
+        }
+        jobs.push_back(std::move(job));
+    }
+    uint32_t numEntryThreads = std::min(getNumThreads(numThreads), std::max((uint32_t)jobs.size(), 1u));
+    atomic<uint32_t> next(0);
+    vector<thread> threads(numEntryThreads);
+    for (uint32_t t = 0; t < numEntryThreads; ++t)
+    {
+        threads[t] = thread(analyzeWork, std::ref(glbState), std::ref(*indirectCG), indirectCallResolver.get(), std::ref(objMgr), std::ref(jobs), std::ref(next));
+    }
+    for (uint32_t t = 0; t < numEntryThreads; ++t)
+    {
+        threads[t].join();
+    }
 
-    // analyze each entry function
     PointsToRecords ptoRes; // pto records of all entry functions
-    DDG ddgRes; // DDG of all entry functions
-    vector<long long> timeRes; // time taken for all entry functions
+    DDG ddgRes(objMgr); // DDG of all entry functions
+    DenseMap<ContextId, ContextId> replayed2Analyzed; // of all entry functions
+    uint64_t numSummaries = 0;
+    uint64_t numReused = 0;
 #ifdef NUM_VISITED_BBS
     uint64_t numVisitedBB = 0;
 #endif
-    for (uint32_t i = 0; i < entryFuncs.size(); ++i)
+    for (unique_ptr<EntryJob> &job : jobs)
     {
-        Context context(entryFuncs[i]);
-        FunctionVisitor vis(glbState, context, cgMap, ptoRes, ddgRes);
-
-        chrono::steady_clock::time_point begin = chrono::steady_clock::now();
-        vis.analyze();
-        chrono::steady_clock::time_point end = chrono::steady_clock::now();
-        timeRes.push_back(std::chrono::duration_cast<chrono::milliseconds>(end - begin).count());
+        ptoRes.merge(job->ptoRecords);
+        ddgRes.merge(job->ddg);
+        if (job->summaryCache)
+        {
+            const DenseMap<ContextId, ContextId> &replayed = job->summaryCache->getReplayedContexts();
+            replayed2Analyzed.insert(replayed.begin(), replayed.end());
+            numSummaries += job->summaryCache->getNumSummaries();
+            numReused += job->summaryCache->getNumReused();
+        }
+        outs() << "It takes " << job->time << "ms to finish analyzing the entry function\n";
 #ifdef NUM_VISITED_BBS
-        numVisitedBB += vis.getNumVisitedBBs();
+        numVisitedBB += job->numVisitedBBs;
 #endif
+        job.reset();
     }
-    for (uint32_t i = 0; i < entryFuncs.size(); ++i)
-    {
-        outs() << "It takes " << timeRes[i] << "ms to finish analyzing the entry function\n";
-    }
+    ddgRes.freezeRelations(getNumThreads(numThreads)); // all relations are added
 #ifdef NUM_VISITED_BBS
     outs() << "Number of basic blocks visited: " << numVisitedBB << '\n';
 #endif
+    outs() << "Number of distinct pointee sets: " << PteeSetManager::getNumSets() << '\n';
+    if (summarizeCalls)
+    {
+        outs() << "Number of function summaries: " << numSummaries << ", reused " << numReused << " times\n";
+    }
     outs() << "DDG size: " << ddgRes.getNumNodes() << " nodes, " << ddgRes.getNumEdges() << " edges\n";
 
     // TODO: whatever way to provide alias info as input and consume it, before building the graph
@@ -111,8 +246,8 @@ int main(int argc, char **argv)
     // print results
     if (doPrint)
     {
-        outs() << ObjectManager::toString() << "\n";
-        outs() << ptoRes.toString() << "\n";
+        outs() << objMgr.toString() << "\n";
+        outs() << ptoRes.toString(objMgr) << "\n";
         outs() << ddgRes.toString() << "\n";
     }
 
@@ -171,25 +306,26 @@ int main(int argc, char **argv)
 
         if (aliasSet.size() >= 2)
         {
-            ObjId objId1 = *aliasSet.begin();
-            ObjId objId2 = *(++aliasSet.begin());
-            outs() << objId1 << " " << objId2 << "\n";
-            ddgRes.addAlias(objId1, objId2);
+            ddgRes.addAliasSet(aliasSet);
         }
     }
 
+    // the graph is complete
+    ddgRes.freeze();
+    outs() << "Frozen DDG: " << ddgRes.getNumNodes() << " nodes, " << ddgRes.getNumEdges() << " edges without duplicates\n";
+
     // search DDG
     outs() << "[*] Searching DDG...\n";
     chrono::steady_clock::time_point begin = chrono::steady_clock::now();
     for (uint32_t i = 0; i < initMemErrs.size(); ++i)
     {
         InitMemErr initMemErr = initMemErrs[i];
-        Context bugCtx = initMemErrCtxs[i];
+        Context bugCtx = FunctionSummaryCache::getAnalyzedContext(initMemErrCtxs[i], replayed2Analyzed); // a summarized call on the trace was analyzed in another context
 
         assert(!initMemErr.callTrace.empty());
         CallTraceItem bugItem = initMemErr.callTrace.back();
         Function *initMemErrFunc = bugCtx.getCurrentFunction();
-        vector<Instruction *> insts = getAllInstsAtSrcLine(initMemErrFunc, bugItem.file, bugItem.line);
+        ArrayRef<Instruction *> insts = glbState.getInstsAtSrcLine(initMemErrFunc, bugItem.file, bugItem.line);
         if (insts.empty())
         {
             outs() << "[-] Cannot find instructions for " << i << "th initial memory errors\n";
@@ -214,7 +350,7 @@ int main(int argc, char **argv)
                 }
 
                 // filter out irrelevant instructions
-                const DataLayout *dataLayout = &bugCtx.entry->getParent()->getDataLayout();
+                const DataLayout *dataLayout = &getThreadDataLayout(bugCtx.getEntry()->getParent());
                 if (initMemErr.memAccessSize == 1 || initMemErr.memAccessSize == 2 || initMemErr.memAccessSize == 4 || initMemErr.memAccessSize == 8)
                 {
                     vector<LoadInst *> copiedLoadInsts = loadInsts;
@@ -228,7 +364,7 @@ int main(int argc, char **argv)
                     }
                 }
 
-                auto it = std::find(entryFuncs.begin(), entryFuncs.end(), bugCtx.entry);
+                auto it = std::find(entryFuncs.begin(), entryFuncs.end(), bugCtx.getEntry());
                 assert(it != entryFuncs.end());
                 if (loadInsts.empty() && memCpyInsts.empty())
                 {
@@ -241,7 +377,7 @@ int main(int argc, char **argv)
                         outs() << "Load Instruction: " << *loadInst << "\n";
 
                         // get accessed obj(s)
-                        set<ObjLoc> ptees = getPteesOfValPtr(dataLayout, ptoRes, bugCtx, loadInst->getPointerOperand(), false);
+                        ArrayRef<ObjLoc> ptees = PteeSetManager::get(getPteesOfValPtr(dataLayout, objMgr, ptoRes, bugCtx, loadInst->getPointerOperand(), false));
                         set<ObjId> objIds;
                         for (auto &ptee : ptees)
                         {
@@ -256,7 +392,13 @@ int main(int argc, char **argv)
                             loadNodes.insert(tmp.begin(), tmp.end());
                         }
 
-                        NodeId id = ddgRes.getOrCreateLoadNode(bugCtx, loadInst);
+                        // the bug site may not have been reached by the analysis
+                        NodeId id = ddgRes.findLoadNode(bugCtx, loadInst);
+                        if (id == noNode)
+                        {
+                            outs() << "[-] The instruction is not in the DDG of its context\n";
+                            continue;
+                        }
                         assert(loadNodes.find(id) != loadNodes.end());
 
                         outs() << std::string(20, '>') << " Initial read error " << std::string(20, '>') << "\n";
@@ -268,7 +410,7 @@ int main(int argc, char **argv)
                         outs() << "MemCpy Instruction: " << *memCPyInst << "\n";
 
                         // get accessed obj(s)
-                        set<ObjLoc> ptees = getPteesOfValPtr(dataLayout, ptoRes, bugCtx, memCPyInst->getSource(), false);
+                        ArrayRef<ObjLoc> ptees = PteeSetManager::get(getPteesOfValPtr(dataLayout, objMgr, ptoRes, bugCtx, memCPyInst->getSource(), false));
                         set<ObjId> objIds;
                         for (auto &ptee : ptees)
                         {
@@ -283,7 +425,13 @@ int main(int argc, char **argv)
                             loadNodes.insert(tmp.begin(), tmp.end());
                         }
 
-                        NodeId id = ddgRes.getOrCreateMemCpyNode(bugCtx, memCPyInst);
+                        // the bug site may not have been reached by the analysis
+                        NodeId id = ddgRes.findMemCpyNode(bugCtx, memCPyInst);
+                        if (id == noNode)
+                        {
+                            outs() << "[-] The instruction is not in the DDG of its context\n";
+                            continue;
+                        }
                         assert(loadNodes.find(id) != loadNodes.end());
 
                         outs() << std::string(20, '>') << " Initial read error " << std::string(20, '>') << "\n";
@@ -1,4 +1,7 @@
+#include "llvm/IR/Module.h"
+
 #include "Object.h"
+#include "Utils.h"
 
 #include <string>
 
@@ -21,6 +24,16 @@ bool ObjLoc::operator<(const ObjLoc &rhs) const
     }
 }
 
+bool ObjLoc::operator==(const ObjLoc &rhs) const
+{
+    return this->objId == rhs.objId && this->offset == rhs.offset;
+}
+
+hash_code hash_value(const ObjLoc &objLoc)
+{
+    return hash_combine(objLoc.objId, objLoc.offset);
+}
+
 StackObject::StackObject(ObjId id, uint64_t size) : id(id), size(size)
 {
 }
@@ -81,106 +94,195 @@ string DummyObject::toString() const
     return res;
 }
 
-ObjId ObjectManager::currObjId = 0;
-map<ObjId, Kind> ObjectManager::objKindMap;
-StackObjectSet ObjectManager::stackObjSet;
-HeapObjectSet ObjectManager::heapObjSet;
-GlbObjectSet ObjectManager::glbObjSet;
-DummyObjectSet ObjectManager::dummyObjSet;
+ObjectShard::ObjectShard() : numDummies(0)
+{
+}
+
+ObjectManager::ObjectManager(const vector<Module *> &moduleList, uint32_t numShards, DummyGranularity dummyGranularity) : shards(numShards), dummyGranularity(dummyGranularity), moduleGlbVarPos(moduleList.size())
+{
+    assert(numShards <= (1u << ObjectManager::ownerBits) && moduleList.size() <= (1u << ObjectManager::ownerBits));
+    for (uint32_t i = 0; i < moduleList.size(); ++i)
+    {
+        this->module2Idx[moduleList[i]] = i;
+    }
+}
 
 ObjId ObjectManager::createStackObject(uint64_t size)
 {
-    ObjId id = ObjectManager::genObjId();
-    ObjectManager::objKindMap[id] = stack;
-    ObjectManager::stackObjSet.insert(StackObject(id, size));
-    return id;
+    ObjectShard &shard = this->getCurrentShard();
+    shard.stackSizes.push_back(size);
+    return ObjectManager::makeId(stack, ShardManager::getCurrentShard(), shard.stackSizes.size() - 1);
 }
 
-ObjId ObjectManager::createHeapObject(InstLoc allocationSite)
+ObjId ObjectManager::createHeapObject(InstLoc allocationSite, offset_t size)
 {
-    ObjId id = ObjectManager::genObjId();
-    ObjectManager::objKindMap[id] = heap;
-    ObjectManager::heapObjSet.insert(HeapObject(id, allocationSite));
-    return id;
+    ObjectShard &shard = this->getCurrentShard();
+    shard.heapSites.push_back(allocationSite);
+    shard.heapSizes.push_back(size);
+    return ObjectManager::makeId(heap, ShardManager::getCurrentShard(), shard.heapSites.size() - 1);
 }
 
 ObjId ObjectManager::getOrCreateGlobalObject(llvm::GlobalVariable *glbVar)
 {
-    auto &glbVarView = ObjectManager::glbObjSet.get<1>();
-    auto it = glbVarView.find(glbVar);
-    if (it != glbVarView.end()) // get
+    lock_guard<std::mutex> lock(this->glbMtx);
+    auto it = this->glbVar2Id.find(glbVar);
+    if (it != this->glbVar2Id.end()) // get
     {
-        return it->id;
+        return it->second;
     }
-    else // create
+
+    // create
+    Module *M = glbVar->getParent();
+    auto itModule = this->module2Idx.find(M);
+    assert(itModule != this->module2Idx.end());
+    DenseMap<GlobalVariable *, uint32_t> &glbVarPos = this->moduleGlbVarPos[itModule->second];
+    if (glbVarPos.empty())
     {
-        ObjId id = ObjectManager::genObjId();
-        ObjectManager::objKindMap[id] = global;
-        ObjectManager::glbObjSet.insert(GlbObject(id, glbVar));
-        return id;
+        uint32_t pos = 0;
+        for (GlobalVariable &G : M->globals())
+        {
+            glbVarPos[&G] = pos++;
+        }
     }
+    ObjId id = ObjectManager::makeId(global, itModule->second, glbVarPos.lookup(glbVar));
+    this->glbVar2Id[glbVar] = id;
+    this->glbObjs[id] = glbVar;
+    return id;
 }
 
 ObjId ObjectManager::createDummyObject()
 {
-    ObjId id = ObjectManager::genObjId();
-    ObjectManager::objKindMap[id] = dummy;
-    ObjectManager::dummyObjSet.insert(DummyObject(id));
+    ObjectShard &shard = this->getCurrentShard();
+    return ObjectManager::makeId(dummy, ShardManager::getCurrentShard(), shard.numDummies++);
+}
+
+ObjId ObjectManager::getOrCreateDummyObject(Value *pointer)
+{
+    if (this->dummyGranularity == perContextValue) // the pointer gets its pointee in the current context
+    {
+        return this->createDummyObject();
+    }
+
+    ObjectShard &shard = this->getCurrentShard();
+    if (this->dummyGranularity == perType)
+    {
+        PointerType *ptrType = dyn_cast<PointerType>(pointer->getType());
+        StructType *st = ptrType && !ptrType->isOpaque() ? dyn_cast<StructType>(ptrType->getPointerElementType()) : nullptr;
+        if (st && st->hasName())
+        {
+            string typeName = trimName(st->getName().str()); // struct.sock.123 and struct.sock are the same type
+            auto it = shard.type2Dummy.find(typeName);
+            if (it != shard.type2Dummy.end())
+            {
+                return it->second;
+            }
+            ObjId id = this->createDummyObject();
+            shard.type2Dummy[typeName] = id;
+            return id;
+        }
+    }
+
+    auto it = shard.value2Dummy.find(pointer);
+    if (it != shard.value2Dummy.end())
+    {
+        return it->second;
+    }
+    ObjId id = this->createDummyObject();
+    shard.value2Dummy[pointer] = id;
     return id;
 }
 
 Kind ObjectManager::getObjectKind(ObjId objId)
 {
-    return ObjectManager::objKindMap.at(objId);
+    return (Kind)(objId >> ObjectManager::kindShift);
 }
 
-string ObjectManager::toString(ObjId objId)
+offset_t ObjectManager::getObjectSize(ObjId objId) const
 {
-    switch (ObjectManager::objKindMap.at(objId))
+    uint32_t owner = ShardManager::getShard(objId) & ((1u << ObjectManager::ownerBits) - 1);
+    uint32_t idx = ShardManager::getIdx(objId);
+    switch (ObjectManager::getObjectKind(objId))
     {
     case stack:
-        return (*ObjectManager::stackObjSet.find(objId)).toString();
+        return this->shards[owner].stackSizes[idx];
     case heap:
-        return (*ObjectManager::heapObjSet.find(objId)).toString();
+        return this->shards[owner].heapSizes[idx];
     case global:
-        return (*ObjectManager::glbObjSet.find(objId)).toString();
+    {
+        GlobalVariable *glbVar;
+        {
+            lock_guard<std::mutex> lock(this->glbMtx); // also for isSized, which caches its result in the type
+            glbVar = this->glbObjs.at(objId);
+            if (!glbVar->getValueType()->isSized())
+            {
+                return -1;
+            }
+        }
+        return getThreadDataLayout(glbVar->getParent()).getTypeAllocSize(glbVar->getValueType());
+    }
+    default:
+        return -1;
+    }
+}
+
+string ObjectManager::toString(ObjId objId) const
+{
+    uint32_t owner = ShardManager::getShard(objId) & ((1u << ObjectManager::ownerBits) - 1);
+    uint32_t idx = ShardManager::getIdx(objId);
+    switch (ObjectManager::getObjectKind(objId))
+    {
+    case stack:
+        return StackObject(objId, this->shards[owner].stackSizes[idx]).toString();
+    case heap:
+        return HeapObject(objId, this->shards[owner].heapSites[idx]).toString();
+    case global:
+        return GlbObject(objId, this->glbObjs.at(objId)).toString();
     case dummy:
-        return (*ObjectManager::dummyObjSet.find(objId)).toString();
+        return DummyObject(objId).toString();
     default:
         return "error";
     }
 }
 
-string ObjectManager::toString()
+string ObjectManager::toString() const
 {
     string res;
     res += "ObjectManager(\n";
 
     res += "StackObjects(\n";
-    for (auto &obj : ObjectManager::stackObjSet)
+    for (uint32_t i = 0; i < this->shards.size(); ++i)
     {
-        res += obj.toString() + "\n";
+        for (uint32_t j = 0; j < this->shards[i].stackSizes.size(); ++j)
+        {
+            res += this->toString(ObjectManager::makeId(stack, i, j)) + "\n";
+        }
     }
     res += ")\n";
 
     res += "HeapObjects(\n";
-    for (auto &obj : ObjectManager::heapObjSet)
+    for (uint32_t i = 0; i < this->shards.size(); ++i)
     {
-        res += obj.toString() + "\n";
+        for (uint32_t j = 0; j < this->shards[i].heapSites.size(); ++j)
+        {
+            res += this->toString(ObjectManager::makeId(heap, i, j)) + "\n";
+        }
     }
     res += ")\n";
 
     res += "GlobalObjects(\n";
-    for (auto &obj : ObjectManager::glbObjSet)
+    for (auto &it : this->glbObjs)
     {
-        res += obj.toString() + "\n";
+        res += GlbObject(it.first, it.second).toString() + "\n";
     }
     res += ")\n";
 
     res += "DummyObjects(\n";
-    for (auto &obj : ObjectManager::dummyObjSet)
+    for (uint32_t i = 0; i < this->shards.size(); ++i)
     {
-        res += obj.toString() + "\n";
+        for (uint32_t j = 0; j < this->shards[i].numDummies; ++j)
+        {
+            res += this->toString(ObjectManager::makeId(dummy, i, j)) + "\n";
+        }
     }
     res += ")\n";
 
@@ -188,7 +290,14 @@ string ObjectManager::toString()
     return res;
 }
 
-ObjId ObjectManager::genObjId()
+ObjId ObjectManager::makeId(Kind kind, uint32_t owner, uint32_t idx)
+{
+    return ((ObjId)kind << ObjectManager::kindShift) | ShardManager::makeId(owner, idx);
+}
+
+ObjectShard &ObjectManager::getCurrentShard()
 {
-    return ObjectManager::currObjId++;
+    ShardId shard = ShardManager::getCurrentShard();
+    assert(shard < this->shards.size());
+    return this->shards[shard];
 }
@@ -1,17 +1,20 @@
 #pragma once
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/Casting.h"
 
+#include "Config.h"
 #include "InstLoc.h"
-
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index/member.hpp>
-#include <boost/multi_index/composite_key.hpp>
+#include "Shard.h"
 
 #include <map>
+#include <mutex>
+#include <string>
+#include <vector>
 
-// Different kinds of memory object
+// Different kinds of memory object. Packed in the top bits of an ObjId
 enum Kind
 {
     stack,
@@ -32,8 +35,11 @@ public:
 
     ObjLoc(ObjId objId, offset_t offset);
     bool operator<(const ObjLoc &rhs) const;
+    bool operator==(const ObjLoc &rhs) const;
 };
 
+llvm::hash_code hash_value(const ObjLoc &objLoc); // for hashing pointee sets
+
 // This class represents a stack object
 class StackObject
 {
@@ -45,13 +51,6 @@ public:
     std::string toString() const;
 };
 
-typedef boost::multi_index::multi_index_container<
-    StackObject,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_unique<
-            boost::multi_index::member<StackObject, ObjId, &StackObject::id>>>>
-    StackObjectSet;
-
 // This class represents a heap object
 class HeapObject
 {
@@ -63,13 +62,6 @@ public:
     std::string toString() const;
 };
 
-typedef boost::multi_index::multi_index_container<
-    HeapObject,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_unique<
-            boost::multi_index::member<HeapObject, ObjId, &HeapObject::id>>>>
-    HeapObjectSet;
-
 // This class represents a global object
 class GlbObject
 {
@@ -81,15 +73,6 @@ public:
     std::string toString() const;
 };
 
-typedef boost::multi_index::multi_index_container<
-    GlbObject,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_unique<
-            boost::multi_index::member<GlbObject, ObjId, &GlbObject::id>>,
-        boost::multi_index::ordered_unique<
-            boost::multi_index::member<GlbObject, llvm::GlobalVariable *, &GlbObject::glbVar>>>>
-    GlbObjectSet;
-
 // This class represents a dummy object
 class DummyObject
 {
@@ -100,31 +83,50 @@ public:
     std::string toString() const;
 };
 
-typedef boost::multi_index::multi_index_container<
-    DummyObject,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_unique<
-            boost::multi_index::member<DummyObject, ObjId, &DummyObject::id>>>>
-    DummyObjectSet;
+// The objects created by the analysis of one entry, by kind. Indexed by the low bits of their ids
+class ObjectShard
+{
+public:
+    std::vector<uint64_t> stackSizes;
+    std::vector<InstLoc> heapSites;
+    std::vector<offset_t> heapSizes; // -1 if unknown
+    uint32_t numDummies;
+    llvm::DenseMap<llvm::Value *, ObjId> value2Dummy; // shared dummy objects
+    llvm::StringMap<ObjId> type2Dummy;
+
+    ObjectShard();
+};
 
+// An ObjId packs the kind of the object, its shard (its module for a global object) and its index in there, so
+// the kind of an object needs no lookup. New objects go to the shard of the calling thread, and each shard must be
+// extended only by its own thread. Global objects are shared by all shards, so they are numbered by their
+// position in their module and created under a lock
 class ObjectManager
 {
 public:
-    static ObjId createStackObject(uint64_t size);
-    static ObjId createHeapObject(InstLoc allocationSite);
-    static ObjId getOrCreateGlobalObject(llvm::GlobalVariable *glbVar);
-    static ObjId createDummyObject();
+    ObjectManager(const std::vector<llvm::Module *> &moduleList, uint32_t numShards, DummyGranularity dummyGranularity);
+    ObjId createStackObject(uint64_t size);
+    ObjId createHeapObject(InstLoc allocationSite, offset_t size); // size is -1 if unknown
+    ObjId getOrCreateGlobalObject(llvm::GlobalVariable *glbVar);
+    ObjId createDummyObject();
+    ObjId getOrCreateDummyObject(llvm::Value *pointer); // the dummy pointee of pointer, shared by dummyGranularity within a shard
     static Kind getObjectKind(ObjId objId);
-    static std::string toString(ObjId objId);
-    static std::string toString();
+    offset_t getObjectSize(ObjId objId) const; // -1 if unknown, as for a dummy object
+    std::string toString(ObjId objId) const;
+    std::string toString() const;
 
 private:
-    static ObjId currObjId;
-    static std::map<ObjId, Kind> objKindMap;
-    static StackObjectSet stackObjSet;
-    static HeapObjectSet heapObjSet;
-    static GlbObjectSet glbObjSet;
-    static DummyObjectSet dummyObjSet;
-
-    static ObjId genObjId();
+    static const uint32_t kindShift = 62;
+    static const uint32_t ownerBits = kindShift - 32;
+
+    std::vector<ObjectShard> shards; // indexed by ShardId
+    DummyGranularity dummyGranularity;
+    mutable std::mutex glbMtx; // guards the global objects
+    llvm::DenseMap<llvm::Module *, uint32_t> module2Idx;
+    std::vector<llvm::DenseMap<llvm::GlobalVariable *, uint32_t>> moduleGlbVarPos; // indexed by module; built on first use
+    llvm::DenseMap<llvm::GlobalVariable *, ObjId> glbVar2Id; // created global objects
+    std::map<ObjId, llvm::GlobalVariable *> glbObjs; // the same, in id order
+
+    static ObjId makeId(Kind kind, uint32_t owner, uint32_t idx);
+    ObjectShard &getCurrentShard();
 };
@@ -1,7 +1,12 @@
 #include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/FileSystem.h"
 
 #include "ParseIR.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <ostream>
 #include <thread>
 
@@ -31,42 +36,95 @@ vector<Module *> parseIRFiles(vector<string> inputFilenames, ostream &out)
     return moduleList;
 }
 
-void parseWork(vector<string> &inputFilenames, vector<Module *> &moduleList, uint32_t start, uint32_t end, ostream &out)
+uint32_t getNumThreads(uint32_t numThreads)
+{
+    if (numThreads == 0)
+    {
+        numThreads = thread::hardware_concurrency();
+    }
+    return std::max(numThreads, 1u);
+}
+
+// Work queue shared by all parsing threads. Files are handed out largest first
+class ParseQueue
+{
+public:
+    vector<string> &inputFilenames;
+    vector<uint32_t> order; // indices into inputFilenames, sorted by decreasing file size
+    atomic<uint32_t> next;
+    vector<long long> parseTimes; // parse time (ms) of each file
+    mutex outMutex; // serializes writes to out
+
+    ParseQueue(vector<string> &inputFilenames) : inputFilenames(inputFilenames), order(inputFilenames.size()), next(0), parseTimes(inputFilenames.size(), 0)
+    {
+        vector<uint64_t> fileSizes(inputFilenames.size(), 0);
+        for (uint32_t i = 0; i < inputFilenames.size(); ++i)
+        {
+            order[i] = i;
+            sys::fs::file_size(inputFilenames[i], fileSizes[i]); // size stays 0 if the file cannot be stat'ed
+        }
+        std::stable_sort(order.begin(), order.end(), [&fileSizes](uint32_t a, uint32_t b) { return fileSizes[a] > fileSizes[b]; });
+    }
+};
+
+void parseWork(ParseQueue &queue, uint32_t threadIdx, bool lazyLoad, const ParseCallback &callback, ostream &out)
 {
     SMDiagnostic Err;
-    for (uint32_t i = start; i < end; ++i)
+    for (uint32_t k = queue.next++; k < queue.order.size(); k = queue.next++)
     {
+        uint32_t i = queue.order[k];
+        chrono::steady_clock::time_point begin = chrono::steady_clock::now();
         LLVMContext *LLVMCtx = new LLVMContext();
-        unique_ptr<Module> MPtr = parseIRFile(inputFilenames[i], Err, *LLVMCtx);
-        if (!MPtr)
+        unique_ptr<Module> MPtr = lazyLoad ? getLazyIRFileModule(queue.inputFilenames[i], Err, *LLVMCtx) : parseIRFile(queue.inputFilenames[i], Err, *LLVMCtx);
+        chrono::steady_clock::time_point end = chrono::steady_clock::now();
+        queue.parseTimes[i] = chrono::duration_cast<chrono::milliseconds>(end - begin).count();
+
         {
-            out << "[-] Error in parsing " << inputFilenames[i] << '\n';
-            continue;
+            lock_guard<mutex> lock(queue.outMutex);
+            if (!MPtr)
+            {
+                out << "[-] Error in parsing " << queue.inputFilenames[i] << '\n';
+                continue;
+            }
+            out << "[+] Parsed (" << i + 1 << ") " << queue.inputFilenames[i] << " in " << queue.parseTimes[i] << "ms\n";
         }
-        Module *M = MPtr.release();
-        out << "[+] Parsed (" << i + 1 << ") " << inputFilenames[i] << "\n";
-        moduleList[i] = M;
+        callback(threadIdx, i, MPtr.release());
     }
 }
 
-vector<Module *> parseIRFilesMultithread(vector<string> inputFilenames, ostream &out)
+void forEachIRFileMultithread(vector<string> &inputFilenames, ostream &out, uint32_t numThreads, bool lazyLoad, const ParseCallback &callback)
 {
     const unsigned numInputFiles = inputFilenames.size();
-    vector<Module *> moduleList(numInputFiles);
-    out << "[*] There are " << numInputFiles << " files to parse\n";
+    numThreads = std::min(getNumThreads(numThreads), std::max(numInputFiles, 1u));
+    out << "[*] There are " << numInputFiles << " files to parse with " << numThreads << " threads\n";
 
-    uint32_t numThreads = 10; // TODO: adjust
-    uint32_t workPerThread = 1 + ((numInputFiles - 1) / numThreads);
+    ParseQueue queue(inputFilenames);
     vector<thread> threads(numThreads);
     for (uint32_t t = 0; t < numThreads; ++t)
     {
-        uint32_t start = workPerThread * t;
-        uint32_t end = std::min(numInputFiles, start + workPerThread);
-        threads[t] = thread(parseWork, std::ref(inputFilenames), std::ref(moduleList), start, end, std::ref(out));
+        threads[t] = thread(parseWork, std::ref(queue), t, lazyLoad, std::cref(callback), std::ref(out));
     }
     for (uint32_t t = 0; t < numThreads; ++t)
     {
         threads[t].join();
     }
+
+    // report the long tail
+    const uint32_t numSlowest = std::min(numInputFiles, 10u);
+    vector<uint32_t> slowest(queue.order);
+    std::partial_sort(slowest.begin(), slowest.begin() + numSlowest, slowest.end(), [&queue](uint32_t a, uint32_t b) { return queue.parseTimes[a] > queue.parseTimes[b]; });
+    out << "[*] Slowest files to parse:\n";
+    for (uint32_t k = 0; k < numSlowest; ++k)
+    {
+        out << "[*] " << queue.parseTimes[slowest[k]] << "ms " << inputFilenames[slowest[k]] << "\n";
+    }
+}
+
+vector<Module *> parseIRFilesMultithread(vector<string> inputFilenames, ostream &out, uint32_t numThreads, bool lazyLoad)
+{
+    vector<Module *> moduleList(inputFilenames.size());
+    forEachIRFileMultithread(inputFilenames, out, numThreads, lazyLoad, [&moduleList](uint32_t, uint32_t fileIdx, Module *M) {
+        moduleList[fileIdx] = M;
+    });
     return moduleList;
 }
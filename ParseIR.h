@@ -4,8 +4,19 @@
 #include "llvm/IR/Module.h"
 #include "llvm/Support/SourceMgr.h"
 
+#include <functional>
 #include <string>
 #include <vector>
 
+// invoked by a parsing thread for each parsed module; takes ownership of the module
+typedef std::function<void(uint32_t threadIdx, uint32_t fileIdx, llvm::Module *M)> ParseCallback;
+
 std::vector<llvm::Module *> parseIRFiles(std::vector<std::string> inputFilenames, std::ostream &out);
-std::vector<llvm::Module *> parseIRFilesMultithread(std::vector<std::string> inputFilenames, std::ostream &out);
+// with lazyLoad, function bodies are left unmaterialized until GlobalState asks for them
+std::vector<llvm::Module *> parseIRFilesMultithread(std::vector<std::string> inputFilenames, std::ostream &out, uint32_t numThreads = 0, bool lazyLoad = false);
+
+// parse files on a pool of at most getNumThreads(numThreads) threads and hand each module to callback as soon as it is parsed
+void forEachIRFileMultithread(std::vector<std::string> &inputFilenames, std::ostream &out, uint32_t numThreads, bool lazyLoad, const ParseCallback &callback);
+
+// number of worker threads to use; 0 means one per hardware thread
+uint32_t getNumThreads(uint32_t numThreads);
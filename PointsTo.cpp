@@ -1,7 +1,12 @@
+#include "llvm/ADT/SmallVector.h"
+
 #include "PointsTo.h"
 #include "Utils.h"
 
-#include <boost/range.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <memory>
 
 #define MEM_SSA true
 
@@ -33,113 +38,393 @@ bool ObjPto::operator<(const ObjPto &rhs) const
     return false;
 }
 
-set<ObjLoc> PointsToRecords::getPteesOfValPtr(Context context, Value *pointer)
+std::mutex PteeSetManager::mtx;
+BumpPtrAllocator PteeSetManager::allocator;
+ArrayRef<ObjLoc> *PteeSetManager::segments[1 << (32 - PteeSetManager::segmentBits)];
+uint32_t PteeSetManager::numSets = 1; // the empty set
+DenseMap<ArrayRef<ObjLoc>, PteeSetId> PteeSetManager::set2Id;
+thread_local DenseMap<pair<PteeSetId, PteeSetId>, PteeSetId> PteeSetManager::unionCache;
+thread_local DenseMap<pair<PteeSetId, offset_t>, PteeSetId> PteeSetManager::shiftCache;
+
+PteeSetId PteeSetManager::getOrCreate(ArrayRef<ObjLoc> pointees)
 {
-    auto &tmp = this->valueData[context];
-    if (tmp.find(pointer) != tmp.end())
+    if (pointees.empty())
+    {
+        return PteeSetManager::emptySet;
+    }
+    lock_guard<std::mutex> lock(PteeSetManager::mtx);
+    auto it = PteeSetManager::set2Id.find(pointees);
+    if (it != PteeSetManager::set2Id.end())
     {
-        return tmp.at(pointer);
+        return it->second;
     }
-    else
+    ObjLoc *data = PteeSetManager::allocator.Allocate<ObjLoc>(pointees.size());
+    std::uninitialized_copy(pointees.begin(), pointees.end(), data);
+    ArrayRef<ObjLoc> interned(data, pointees.size());
+
+    // a set is written before its id is handed out, so readers need no lock
+    PteeSetId id = PteeSetManager::numSets++;
+    ArrayRef<ObjLoc> *&segment = PteeSetManager::segments[id >> PteeSetManager::segmentBits];
+    if (!segment)
     {
-        return set<ObjLoc>();
+        segment = PteeSetManager::allocator.Allocate<ArrayRef<ObjLoc>>(PteeSetManager::segmentSize);
     }
+    segment[id & (PteeSetManager::segmentSize - 1)] = interned;
+    PteeSetManager::set2Id[interned] = id;
+    return id;
 }
 
-void PointsToRecords::addPteesForValPtr(Context context, Value *pointer, set<ObjLoc> pointees)
+PteeSetId PteeSetManager::getSingleton(ObjLoc pointee)
 {
-    if (pointees.empty())
+    return PteeSetManager::getOrCreate(ArrayRef<ObjLoc>(pointee));
+}
+
+PteeSetId PteeSetManager::unite(PteeSetId lhs, PteeSetId rhs)
+{
+    if (lhs == rhs || rhs == PteeSetManager::emptySet)
+    {
+        return lhs;
+    }
+    if (lhs == PteeSetManager::emptySet)
+    {
+        return rhs;
+    }
+    pair<PteeSetId, PteeSetId> key = std::minmax(lhs, rhs);
+    auto it = PteeSetManager::unionCache.find(key);
+    if (it != PteeSetManager::unionCache.end())
+    {
+        return it->second;
+    }
+    ArrayRef<ObjLoc> lhsPtees = PteeSetManager::get(lhs);
+    ArrayRef<ObjLoc> rhsPtees = PteeSetManager::get(rhs);
+    SmallVector<ObjLoc, 8> merged;
+    std::set_union(lhsPtees.begin(), lhsPtees.end(), rhsPtees.begin(), rhsPtees.end(), std::back_inserter(merged));
+    PteeSetId res = PteeSetManager::getOrCreate(merged);
+    PteeSetManager::unionCache[key] = res;
+    return res;
+}
+
+PteeSetId PteeSetManager::shift(PteeSetId id, offset_t offset)
+{
+    if (offset == 0 || id == PteeSetManager::emptySet)
+    {
+        return id;
+    }
+    pair<PteeSetId, offset_t> key(id, offset);
+    auto it = PteeSetManager::shiftCache.find(key);
+    if (it != PteeSetManager::shiftCache.end())
+    {
+        return it->second;
+    }
+    // shifting every offset of an object by the same amount keeps the order
+    SmallVector<ObjLoc, 8> shifted;
+    for (ObjLoc pointee : PteeSetManager::get(id))
+    {
+        shifted.push_back(ObjLoc(pointee.objId, pointee.offset + offset));
+    }
+    PteeSetId res = PteeSetManager::getOrCreate(shifted);
+    PteeSetManager::shiftCache[key] = res;
+    return res;
+}
+
+ArrayRef<ObjLoc> PteeSetManager::get(PteeSetId id)
+{
+    if (id == PteeSetManager::emptySet)
+    {
+        return ArrayRef<ObjLoc>();
+    }
+    return PteeSetManager::segments[id >> PteeSetManager::segmentBits][id & (PteeSetManager::segmentSize - 1)];
+}
+
+uint64_t PteeSetManager::getNumSets()
+{
+    lock_guard<std::mutex> lock(PteeSetManager::mtx);
+    return PteeSetManager::numSets;
+}
+
+ObjPtoVersion::ObjPtoVersion(InstLoc instLoc, PteeSetId pointees, bool killsOlder) : instLoc(instLoc), pointees(pointees), killsOlder(killsOlder)
+{
+}
+
+ObjPtoFrame::ObjPtoFrame(ContextId context) : context(context), allPointees(PteeSetManager::emptySet)
+{
+}
+
+void ObjPtoChain::add(const ObjPtoVersion &version)
+{
+    auto it = this->context2Frame.find(version.instLoc.context.id);
+    if (it == this->context2Frame.end())
+    {
+        it = this->context2Frame.insert(std::make_pair(version.instLoc.context.id, this->frames.size())).first;
+        this->frames.push_back(ObjPtoFrame(version.instLoc.context.id));
+    }
+    ObjPtoFrame &frame = this->frames[it->second];
+    frame.versionIdxs.push_back(this->versions.size());
+    frame.allPointees = PteeSetManager::unite(frame.allPointees, version.pointees);
+    this->versions.push_back(version);
+}
+
+ObjPtoUpdate::ObjPtoUpdate(ObjLoc pointer, PteeSetId pointees) : pointer(pointer), pointees(pointees)
+{
+}
+
+PointsToRecords::PointsToRecords() : logAccesses(false)
+{
+}
+
+PteeSetId PointsToRecords::getPteesOfValPtr(Context context, Value *pointer)
+{
+    auto it = this->valueData.find(CtxValue(context.id, pointer));
+    if (it != this->valueData.end())
+    {
+        return it->second;
+    }
+    return PteeSetManager::emptySet;
+}
+
+void PointsToRecords::addPteesForValPtr(Context context, Value *pointer, PteeSetId pointees)
+{
+    if (pointees == PteeSetManager::emptySet)
     {
         return;
     }
-    this->valueData[context][pointer].insert(pointees.begin(), pointees.end());
+    PteeSetId &ptees = this->valueData[CtxValue(context.id, pointer)];
+    ptees = PteeSetManager::unite(ptees, pointees);
 }
 
-string PointsToRecords::toString()
+string PointsToRecords::toString(const ObjectManager &objMgr)
 {
     string res;
 
+    // print in (context, value) order
+    vector<CtxValue> keys;
+    for (auto &it : this->valueData)
+    {
+        keys.push_back(it.first);
+    }
+    std::sort(keys.begin(), keys.end());
+
     res += "StackPtoRecords(\n";
-    for (auto &itCtx : this->valueData)
+    for (uint32_t i = 0; i < keys.size(); ++i)
     {
-        res += "context(";
-        res += itCtx.first.toString();
-        res += "\n";
-        for (auto &itVal : itCtx.second)
+        if (i == 0 || keys[i].first != keys[i - 1].first)
         {
-            res += getName(itVal.first);
-            res += " -> [";
+            res += "context(";
+            res += Context(keys[i].first).toString();
+            res += "\n";
+        }
+        res += getName(keys[i].second);
+        res += " -> [";
 
-            for (auto &itObjLoc : itVal.second)
-            {
-                res += "(";
-                res += ObjectManager::toString(itObjLoc.objId);
-                res += ", ";
-                res += to_string(itObjLoc.offset);
-                res += "), ";
-            }
-            res += "]\n";
+        for (auto &itObjLoc : PteeSetManager::get(this->valueData[keys[i]]))
+        {
+            res += "(";
+            res += objMgr.toString(itObjLoc.objId);
+            res += ", ";
+            res += to_string(itObjLoc.offset);
+            res += "), ";
+        }
+        res += "]\n";
+        if (i + 1 == keys.size() || keys[i].first != keys[i + 1].first)
+        {
+            res += ")\n";
         }
-        res += ")\n";
     }
     res += ")\n";
 
     res += "ObjPtoRecords(\n";
-    for (auto &objPto : this->objPtos)
-    {
-        res += "(";
-        res += ObjectManager::toString(objPto.srcObjId);
-        res += ", ";
-        res += to_string(objPto.srcOffset);
-        res += ") -> (";
-        res += "(";
-        res += ObjectManager::toString(objPto.dstObjId);
-        res += ", ";
-        res += to_string(objPto.dstOffset);
-        res += ")\n";
+    for (auto &chain : this->objPtoChains)
+    {
+        for (auto &version : chain.second.versions)
+        {
+            for (auto &pointee : PteeSetManager::get(version.pointees))
+            {
+                res += "(";
+                res += objMgr.toString(chain.first.objId);
+                res += ", ";
+                res += to_string(chain.first.offset);
+                res += ") -> (";
+                res += "(";
+                res += objMgr.toString(pointee.objId);
+                res += ", ";
+                res += to_string(pointee.offset);
+                res += ")\n";
+            }
+        }
     }
     res += ")";
 
     return res;
 }
 
-set<ObjLoc> PointsToRecords::getPteesOfObjPtr(ObjLoc pointer, InstLoc currLoc)
+// whether context is callee or below it
+static bool isInCallee(ContextId context, Context callee)
+{
+    uint32_t calleeDepth = callee.getDepth();
+    while (ContextManager::getNode(context).depth > calleeDepth)
+    {
+        context = ContextManager::getNode(context).parent;
+    }
+    return context == callee.id;
+}
+
+PteeSetId PointsToRecords::getPteesOfObjPtr(ObjLoc pointer, InstLoc currLoc)
+{
+    if (this->logAccesses)
+    {
+        this->loadLog.push_back(pointer);
+    }
+    return this->lookupPtees(pointer, currLoc, nullptr);
+}
+
+PteeSetId PointsToRecords::getPteesBeforeCall(ObjLoc pointer, Context callee)
+{
+    ContextNode node = ContextManager::getNode(callee.id);
+    return this->lookupPtees(pointer, InstLoc(Context(node.parent), node.callInst), &callee);
+}
+
+PteeSetId PointsToRecords::lookupPtees(ObjLoc pointer, InstLoc currLoc, const Context *skippedCallee)
 {
-    set<ObjLoc> res;
-    auto &srcView = this->objPtos.get<0>();
-    for (auto &objPto : boost::make_iterator_range(srcView.equal_range(boost::make_tuple(pointer.objId, pointer.offset))))
+    PteeSetId res = PteeSetManager::emptySet;
+    auto it = this->objPtoChains.find(pointer);
+    if (it == this->objPtoChains.end())
     {
+        return res;
+    }
+    ObjPtoChain &chain = it->second;
 #if MEM_SSA
-        if (isReachable(objPto.instLoc, currLoc))
+    // the newest version that reaches currLoc and kills the older ones. It dominates currLoc, so its frame is on the
+    // call stack of currLoc
+    uint32_t killIdx = 0;
+    for (ContextId ctx = currLoc.context.id;; ctx = ContextManager::getNode(ctx).parent)
+    {
+        auto itFrame = chain.context2Frame.find(ctx);
+        if (itFrame != chain.context2Frame.end())
         {
-#endif
-            res.insert(ObjLoc(objPto.dstObjId, objPto.dstOffset));
-#if MEM_SSA
+            vector<uint32_t> &versionIdxs = chain.frames[itFrame->second].versionIdxs;
+            for (auto idx = versionIdxs.rbegin(); idx != versionIdxs.rend() && *idx > killIdx; ++idx)
+            {
+                ObjPtoVersion &version = chain.versions[*idx];
+                if (version.killsOlder && isReachable(version.instLoc, currLoc) && dominates(version.instLoc, currLoc))
+                {
+                    killIdx = *idx;
+                    break;
+                }
+            }
+        }
+        if (ContextManager::getNode(ctx).depth == 1)
+        {
+            break;
+        }
+    }
+
+    // the versions since then that reach currLoc
+    for (ObjPtoFrame &frame : chain.frames)
+    {
+        if (frame.versionIdxs.back() < killIdx || (skippedCallee && isInCallee(frame.context, *skippedCallee)))
+        {
+            continue;
+        }
+        ContextReachQuery query = ReachabilityManager::getContextReachQuery(frame.context, currLoc.context.id);
+        if (query.unreachable)
+        {
+            continue;
+        }
+        if (query.fromInst) // not on the call stack of currLoc, so all versions reach it through the same call
+        {
+            if (!ReachabilityManager::isPotentiallyReachable(query.fromInst, query.toInst ? query.toInst : currLoc.inst))
+            {
+                continue;
+            }
+            if (frame.versionIdxs.front() >= killIdx)
+            {
+                res = PteeSetManager::unite(res, frame.allPointees);
+                continue;
+            }
+        }
+        for (auto idx = frame.versionIdxs.rbegin(); idx != frame.versionIdxs.rend() && *idx >= killIdx; ++idx)
+        {
+            ObjPtoVersion &version = chain.versions[*idx];
+            if (query.fromInst || isReachable(version.instLoc, currLoc))
+            {
+                res = PteeSetManager::unite(res, version.pointees);
+            }
         }
-#endif
     }
+#else
+    for (ObjPtoFrame &frame : chain.frames)
+    {
+        if (!skippedCallee || !isInCallee(frame.context, *skippedCallee))
+        {
+            res = PteeSetManager::unite(res, frame.allPointees);
+        }
+    }
+#endif
     return res;
 }
 
-void PointsToRecords::addPteesForObjPtr(ObjLoc pointer, set<ObjLoc> pointees, InstLoc updateLoc)
+void PointsToRecords::addPteesForObjPtr(ObjLoc pointer, PteeSetId pointees, InstLoc updateLoc, bool strongUpdate)
 {
-    if (pointees.empty())
+    if (pointees == PteeSetManager::emptySet)
     {
         return;
     }
-    for (auto &pointee : pointees)
+    // Older versions of the same entry were analyzed earlier, i.e. before updateLoc in the SCC order of each function
+    // on its context. Unless updateLoc may repeat in a cycle, none of them is reachable from it
+    bool killsOlder = strongUpdate && !isInCycle(updateLoc);
+    this->objPtoChains[pointer].add(ObjPtoVersion(updateLoc, pointees, killsOlder));
+    if (this->logAccesses)
     {
-        this->objPtos.insert(ObjPto(pointer.objId, pointer.offset, pointee.objId, pointee.offset, updateLoc));
+        this->updateLog.push_back(ObjPtoUpdate(pointer, pointees));
     }
 }
 
 set<ObjPto> PointsToRecords::getRecordsOfObj(ObjId objId)
 {
     set<ObjPto> res;
-    auto &srcView = this->objPtos.get<0>();
-    for (auto &objPto : boost::make_iterator_range(srcView.equal_range(objId)))
+    for (auto it = this->objPtoChains.lower_bound(ObjLoc(objId, INT64_MIN)); it != this->objPtoChains.end() && it->first.objId == objId; ++it)
     {
-        res.insert(objPto);
+        for (auto &version : it->second.versions)
+        {
+            for (auto &pointee : PteeSetManager::get(version.pointees))
+            {
+                res.insert(ObjPto(objId, it->first.offset, pointee.objId, pointee.offset, version.instLoc));
+            }
+        }
     }
     return res;
 }
+
+void PointsToRecords::setLogAccesses(bool logAccesses)
+{
+    this->logAccesses = logAccesses;
+}
+
+vector<ObjPtoUpdate> &PointsToRecords::getUpdateLog()
+{
+    return this->updateLog;
+}
+
+vector<ObjLoc> &PointsToRecords::getLoadLog()
+{
+    return this->loadLog;
+}
+
+void PointsToRecords::merge(PointsToRecords &shard)
+{
+    for (auto &it : shard.valueData)
+    {
+        PteeSetId &ptees = this->valueData[it.first];
+        ptees = PteeSetManager::unite(ptees, it.second);
+    }
+
+    // versions of different entries never reach each other, so only their order in a chain matters
+    for (auto &chain : shard.objPtoChains)
+    {
+        ObjPtoChain &versions = this->objPtoChains[chain.first];
+        for (const ObjPtoVersion &version : chain.second.versions)
+        {
+            versions.add(version);
+        }
+    }
+}
@@ -1,16 +1,17 @@
 #pragma once
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/IR/Value.h"
 
 #include "InstLoc.h"
 #include "Object.h"
 
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index/member.hpp>
-#include <boost/multi_index/composite_key.hpp>
-
+#include <map>
+#include <mutex>
 #include <set>
+#include <vector>
 
 // This class represents the relation of one memory object pointing to another memory object
 class ObjPto
@@ -26,32 +27,113 @@ public:
     bool operator<(const ObjPto &rhs) const; // for std::set
 };
 
-typedef boost::multi_index::multi_index_container<
-    ObjPto,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_non_unique<
-            boost::multi_index::composite_key<
-                ObjPto,
-                boost::multi_index::member<ObjPto, ObjId, &ObjPto::srcObjId>,
-                boost::multi_index::member<ObjPto, offset_t, &ObjPto::srcOffset>>>>>
-    ObjPtos;
+typedef uint32_t PteeSetId; // 0 is the empty set
+
+// Interns each distinct pointee set once. Sets are sorted, immutable and never freed, so two sets are equal
+// iff their ids are, and the ArrayRef of a set stays valid. Union and offset shift are memoized per thread.
+// All methods are thread-safe; sets are read without locking
+class PteeSetManager
+{
+public:
+    static const PteeSetId emptySet = 0;
+
+    static PteeSetId getOrCreate(llvm::ArrayRef<ObjLoc> pointees); // pointees must be sorted and unique
+    static PteeSetId getSingleton(ObjLoc pointee);
+    static PteeSetId unite(PteeSetId lhs, PteeSetId rhs);
+    static PteeSetId shift(PteeSetId id, offset_t offset); // add offset to every pointee
+    static llvm::ArrayRef<ObjLoc> get(PteeSetId id);
+    static uint64_t getNumSets();
+
+private:
+    static const uint32_t segmentBits = 16;
+    static const uint32_t segmentSize = 1 << segmentBits;
+
+    static std::mutex mtx; // guards the creation of sets
+    static llvm::BumpPtrAllocator allocator;
+    static llvm::ArrayRef<ObjLoc> *segments[1 << (32 - segmentBits)]; // indexed by PteeSetId; never moved, unlike a vector
+    static uint32_t numSets;
+    static llvm::DenseMap<llvm::ArrayRef<ObjLoc>, PteeSetId> set2Id;
+    static thread_local llvm::DenseMap<std::pair<PteeSetId, PteeSetId>, PteeSetId> unionCache; // smaller id first
+    static thread_local llvm::DenseMap<std::pair<PteeSetId, offset_t>, PteeSetId> shiftCache;
+};
+
+// A store of pointers to an (object, offset), i.e. one version in its memory SSA chain
+class ObjPtoVersion
+{
+public:
+    InstLoc instLoc;
+    PteeSetId pointees;
+    bool killsOlder; // strong update outside any cycle, so no older version is reachable from it
+
+    ObjPtoVersion(InstLoc instLoc, PteeSetId pointees, bool killsOlder);
+};
+
+// An update of the pointees of an object location, as logged for function summaries
+class ObjPtoUpdate
+{
+public:
+    ObjLoc pointer;
+    PteeSetId pointees;
+
+    ObjPtoUpdate(ObjLoc pointer, PteeSetId pointees);
+};
+
+typedef std::pair<ContextId, llvm::Value *> CtxValue;
+
+// The versions of an (object, offset) written in one context
+class ObjPtoFrame
+{
+public:
+    ContextId context;
+    std::vector<uint32_t> versionIdxs; // ascending
+    PteeSetId allPointees; // of all versions
+
+    ObjPtoFrame(ContextId context);
+};
+
+// The memory SSA chain of an (object, offset). Versions are in the order of analysis, which follows program order
+// within a context, and are grouped into frames by context. All versions of a frame reach a location in another
+// context, or none do, unless the frame is on the call stack of the location
+class ObjPtoChain
+{
+public:
+    std::vector<ObjPtoVersion> versions;
+    std::vector<ObjPtoFrame> frames;
+    llvm::DenseMap<ContextId, uint32_t> context2Frame;
+
+    void add(const ObjPtoVersion &version);
+};
+
+typedef std::map<ObjLoc, ObjPtoChain> ObjPtoChains;
 
 class PointsToRecords
 {
 private:
     std::map<llvm::GlobalVariable *, std::set<ObjLoc>> globalData;
-    std::map<Context, std::map<llvm::Value *, std::set<ObjLoc>>> valueData;
-    ObjPtos objPtos;
+    llvm::DenseMap<CtxValue, PteeSetId> valueData;
+    ObjPtoChains objPtoChains;
+    bool logAccesses;
+    std::vector<ObjPtoUpdate> updateLog; // object updates while logAccesses
+    std::vector<ObjLoc> loadLog; // object loads while logAccesses
+
+    PteeSetId lookupPtees(ObjLoc pointer, InstLoc currLoc, const Context *skippedCallee); // ignoring the versions inside skippedCallee if any
 
 public:
+    PointsToRecords();
+
     // value
-    std::set<ObjLoc> getPteesOfValPtr(Context context, llvm::Value *pointer);
-    void addPteesForValPtr(Context context, llvm::Value *pointer, std::set<ObjLoc> pointees);
+    PteeSetId getPteesOfValPtr(Context context, llvm::Value *pointer);
+    void addPteesForValPtr(Context context, llvm::Value *pointer, PteeSetId pointees);
 
     // object
-    std::set<ObjLoc> getPteesOfObjPtr(ObjLoc pointer, InstLoc currLoc);
-    void addPteesForObjPtr(ObjLoc pointer, std::set<ObjLoc> pointees, InstLoc updateLoc);
+    PteeSetId getPteesOfObjPtr(ObjLoc pointer, InstLoc currLoc); // a load
+    PteeSetId getPteesBeforeCall(ObjLoc pointer, Context callee); // at the call of callee, as written outside it
+    void addPteesForObjPtr(ObjLoc pointer, PteeSetId pointees, InstLoc updateLoc, bool strongUpdate = false); // strongUpdate if pointer is the only location written
     std::set<ObjPto> getRecordsOfObj(ObjId objId);
+    void setLogAccesses(bool logAccesses);
+    std::vector<ObjPtoUpdate> &getUpdateLog();
+    std::vector<ObjLoc> &getLoadLog();
+    void merge(PointsToRecords &shard); // append the records of a later entry, as if it was analyzed after this one
 
-    std::string toString();
+    std::string toString(const ObjectManager &objMgr);
 };
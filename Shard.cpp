@@ -0,0 +1,28 @@
+#include "Shard.h"
+
+thread_local ShardId ShardManager::currShard = 0;
+
+void ShardManager::setCurrentShard(ShardId shard)
+{
+    ShardManager::currShard = shard;
+}
+
+ShardId ShardManager::getCurrentShard()
+{
+    return ShardManager::currShard;
+}
+
+uint64_t ShardManager::makeId(ShardId shard, uint32_t idx)
+{
+    return ((uint64_t)shard << 32) | idx;
+}
+
+ShardId ShardManager::getShard(uint64_t id)
+{
+    return id >> 32;
+}
+
+uint32_t ShardManager::getIdx(uint64_t id)
+{
+    return (uint32_t)id;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+typedef uint32_t ShardId;
+
+// Contexts and objects created by the analysis of different entries go to different shards, so that their ids
+// only depend on the entry, whichever thread analyzes it. Shard 0 is used outside the analysis of entries
+class ShardManager
+{
+public:
+    static void setCurrentShard(ShardId shard); // for the calling thread
+    static ShardId getCurrentShard();
+
+    // ids are (shard, index in shard)
+    static uint64_t makeId(ShardId shard, uint32_t idx);
+    static ShardId getShard(uint64_t id);
+    static uint32_t getIdx(uint64_t id);
+
+private:
+    static thread_local ShardId currShard;
+};
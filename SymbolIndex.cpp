@@ -0,0 +1,383 @@
+#include "llvm/IR/InstIterator.h"
+#include "llvm/Support/Chrono.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/xxhash.h"
+
+#include "IndirectCallResolver.h"
+#include "ParseIR.h"
+#include "SymbolIndex.h"
+#include "Utils.h"
+
+#include <fstream>
+#include <queue>
+#include <set>
+#include <sstream>
+
+using namespace llvm;
+using namespace std;
+
+IndexedFile::IndexedFile(string path) : path(path), size(0), mtime(0), hash(0)
+{
+}
+
+IndexedFunc::IndexedFunc(string name, uint32_t fileIdx, char linkage) : name(name), fileIdx(fileIdx), linkage(linkage)
+{
+}
+
+// fill in size and mtime. Returns false if the file cannot be stat'ed
+static bool statFile(IndexedFile &file)
+{
+    sys::fs::file_status status;
+    if (sys::fs::status(file.path, status))
+    {
+        return false;
+    }
+    file.size = status.getSize();
+    file.mtime = sys::toTimeT(status.getLastModificationTime());
+    return true;
+}
+
+static uint64_t hashFile(string path)
+{
+    ErrorOr<unique_ptr<MemoryBuffer>> buffer = MemoryBuffer::getFile(path, false, false);
+    if (!buffer)
+    {
+        return 0;
+    }
+    return xxHash64((*buffer)->getBuffer());
+}
+
+SymbolIndex::SymbolIndex(string indexFilename, vector<string> inputFilenames, uint32_t numThreads, ostream &out)
+{
+    map<string, IndexedFile> oldFiles;
+    multimap<string, IndexedFunc> oldFuncs; // path -> function
+    bool changed = !this->load(indexFilename, oldFiles, oldFuncs);
+
+    // reuse the entries of unchanged files
+    vector<string> staleFilenames;
+    vector<uint32_t> staleFileIdxs;
+    for (uint32_t i = 0; i < inputFilenames.size(); ++i)
+    {
+        IndexedFile file(inputFilenames[i]);
+        bool exists = statFile(file);
+        auto itOld = oldFiles.find(file.path);
+        if (itOld != oldFiles.end() && exists && itOld->second.size == file.size && itOld->second.mtime == file.mtime)
+        {
+            file.hash = itOld->second.hash;
+        }
+        else
+        {
+            file.hash = exists ? hashFile(file.path) : 0;
+            changed = true;
+        }
+
+        if (itOld != oldFiles.end() && exists && itOld->second.hash == file.hash)
+        {
+            file.addrTakenFuncs = itOld->second.addrTakenFuncs;
+            auto range = oldFuncs.equal_range(file.path);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                IndexedFunc func = it->second;
+                func.fileIdx = i;
+                this->funcs.push_back(func);
+            }
+        }
+        else
+        {
+            staleFilenames.push_back(file.path);
+            staleFileIdxs.push_back(i);
+        }
+        this->files.push_back(file);
+    }
+    changed = changed || oldFiles.size() != inputFilenames.size();
+
+    // (re-)index new and changed files
+    if (!staleFilenames.empty())
+    {
+        out << "[*] Indexing " << staleFilenames.size() << " new or changed files\n";
+        vector<vector<IndexedFunc>> staleFuncs(staleFilenames.size());
+        forEachIRFileMultithread(staleFilenames, out, numThreads, false, [this, &staleFileIdxs, &staleFuncs](uint32_t, uint32_t k, Module *M) {
+            this->indexModule(*M, staleFileIdxs[k], staleFuncs[k]);
+            LLVMContext &LLVMCtx = M->getContext();
+            delete M;
+            delete &LLVMCtx;
+        });
+        for (vector<IndexedFunc> &each : staleFuncs)
+        {
+            this->funcs.insert(this->funcs.end(), each.begin(), each.end());
+        }
+    }
+
+    for (uint32_t i = 0; i < this->funcs.size(); ++i)
+    {
+        this->name2Funcs.insert(std::make_pair(this->funcs[i].name, i));
+    }
+
+    if (changed)
+    {
+        this->save(indexFilename);
+    }
+}
+
+vector<string> SymbolIndex::getRequiredFiles(vector<string> rootFuncs, const DSimpleCGMap &dSimpleCGMap, uint32_t maxCallDepth, bool resolveIndirectCalls)
+{
+    return this->collectRequiredFiles(rootFuncs, [&dSimpleCGMap](const string &name, vector<string> &res) {
+        auto it = dSimpleCGMap.find(name);
+        if (it != dSimpleCGMap.end())
+        {
+            res.insert(res.end(), it->second.begin(), it->second.end());
+        }
+    }, maxCallDepth, resolveIndirectCalls);
+}
+
+vector<string> SymbolIndex::getRequiredFiles(vector<string> rootFuncs, const BinaryCG &binaryCG, uint32_t maxCallDepth, bool resolveIndirectCalls)
+{
+    return this->collectRequiredFiles(rootFuncs, [&binaryCG](const string &name, vector<string> &res) {
+        for (uint32_t calleeIdx : binaryCG.findCallees(name))
+        {
+            res.push_back(binaryCG.getName(calleeIdx).str());
+        }
+    }, maxCallDepth, resolveIndirectCalls);
+}
+
+vector<string> SymbolIndex::collectRequiredFiles(vector<string> &rootFuncs, const IndirectCalleesGetter &getIndirectCallees, uint32_t maxCallDepth, bool resolveIndirectCalls)
+{
+    // the candidate callees of indirect calls by type, with the files taking their addresses
+    multimap<uint64_t, pair<string, uint32_t>> type2AddrTakenFuncs;
+    if (resolveIndirectCalls)
+    {
+        for (uint32_t fileIdx = 0; fileIdx < this->files.size(); ++fileIdx)
+        {
+            for (pair<uint64_t, string> &each : this->files[fileIdx].addrTakenFuncs)
+            {
+                type2AddrTakenFuncs.insert(std::make_pair(each.first, std::make_pair(each.second, fileIdx)));
+            }
+        }
+    }
+
+    set<string> visited;
+    set<uint32_t> fileIdxs;
+    queue<pair<string, uint32_t>> worklist; // function name, call depth
+    for (string &name : rootFuncs)
+    {
+        worklist.push(std::make_pair(name, 1));
+    }
+    while (!worklist.empty())
+    {
+        string name = worklist.front().first;
+        uint32_t depth = worklist.front().second;
+        worklist.pop();
+        if (!visited.insert(name).second)
+        {
+            continue;
+        }
+
+        auto range = this->name2Funcs.equal_range(name);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            IndexedFunc &func = this->funcs[it->second];
+            fileIdxs.insert(func.fileIdx);
+            if (depth < maxCallDepth)
+            {
+                for (string &callee : func.callees)
+                {
+                    worklist.push(std::make_pair(callee, depth + 1));
+                }
+                for (uint64_t typeHash : func.indirectCallTypes)
+                {
+                    auto candidates = type2AddrTakenFuncs.equal_range(typeHash);
+                    for (auto itCand = candidates.first; itCand != candidates.second; ++itCand)
+                    {
+                        fileIdxs.insert(itCand->second.second);
+                        worklist.push(std::make_pair(itCand->second.first, depth + 1));
+                    }
+                }
+            }
+        }
+
+        // indirect callees
+        if (depth < maxCallDepth)
+        {
+            vector<string> callees;
+            getIndirectCallees(name, callees);
+            for (string &callee : callees)
+            {
+                worklist.push(std::make_pair(callee, depth + 1));
+            }
+        }
+    }
+
+    vector<string> res;
+    for (uint32_t fileIdx : fileIdxs)
+    {
+        res.push_back(this->files[fileIdx].path);
+    }
+    return res;
+}
+
+// Index file format, one record per line after the version line:
+//   file <hash> <size> <mtime> <path>
+//   addr <type hash> <name>                    (address-taken function in the preceding file)
+//   func <linkage> <name> [<callee> ...]       (belongs to the preceding file)
+//   icalls <type hash> ...                     (indirect calls of the preceding function)
+static const string indexVersion = "symindex 2";
+
+bool SymbolIndex::load(string indexFilename, map<string, IndexedFile> &oldFiles, multimap<string, IndexedFunc> &oldFuncs)
+{
+    ifstream s(indexFilename);
+    if (!s.is_open())
+    {
+        return false;
+    }
+
+    // an index of another format is rebuilt
+    string line;
+    if (!getline(s, line) || line != indexVersion)
+    {
+        return false;
+    }
+
+    IndexedFile *currFile = nullptr;
+    IndexedFunc *currFunc = nullptr;
+    while (getline(s, line))
+    {
+        istringstream ss(line);
+        string kind;
+        ss >> kind;
+        if (kind == "file")
+        {
+            IndexedFile file("");
+            ss >> file.hash >> file.size >> file.mtime;
+            ss.get(); // skip the separator before the path
+            getline(ss, file.path);
+            currFile = &oldFiles.insert(std::make_pair(file.path, file)).first->second;
+            currFunc = nullptr;
+        }
+        else if (kind == "addr" && currFile)
+        {
+            uint64_t typeHash;
+            string name;
+            ss >> typeHash >> name;
+            currFile->addrTakenFuncs.push_back(std::make_pair(typeHash, name));
+        }
+        else if (kind == "func" && currFile)
+        {
+            char linkage;
+            string name;
+            ss >> linkage >> name;
+            IndexedFunc func(name, 0, linkage);
+            string callee;
+            while (ss >> callee)
+            {
+                func.callees.push_back(callee);
+            }
+            currFunc = &oldFuncs.insert(std::make_pair(currFile->path, func))->second;
+        }
+        else if (kind == "icalls" && currFunc)
+        {
+            uint64_t typeHash;
+            while (ss >> typeHash)
+            {
+                currFunc->indirectCallTypes.push_back(typeHash);
+            }
+        }
+    }
+    return true;
+}
+
+void SymbolIndex::save(string indexFilename)
+{
+    vector<vector<uint32_t>> funcsOfFile(this->files.size());
+    for (uint32_t i = 0; i < this->funcs.size(); ++i)
+    {
+        funcsOfFile[this->funcs[i].fileIdx].push_back(i);
+    }
+
+    ofstream s(indexFilename);
+    s << indexVersion << "\n";
+    for (uint32_t fileIdx = 0; fileIdx < this->files.size(); ++fileIdx)
+    {
+        IndexedFile &file = this->files[fileIdx];
+        s << "file " << file.hash << " " << file.size << " " << file.mtime << " " << file.path << "\n";
+        for (pair<uint64_t, string> &each : file.addrTakenFuncs)
+        {
+            s << "addr " << each.first << " " << each.second << "\n";
+        }
+        for (uint32_t funcIdx : funcsOfFile[fileIdx])
+        {
+            IndexedFunc &func = this->funcs[funcIdx];
+            s << "func " << func.linkage << " " << func.name;
+            for (string &callee : func.callees)
+            {
+                s << " " << callee;
+            }
+            s << "\n";
+            if (!func.indirectCallTypes.empty())
+            {
+                s << "icalls";
+                for (uint64_t typeHash : func.indirectCallTypes)
+                {
+                    s << " " << typeHash;
+                }
+                s << "\n";
+            }
+        }
+    }
+}
+
+// same linkage rules as GlobalState::genModuleFacts, and same address-taken functions and indirect calls as
+// IndirectCallResolver
+void SymbolIndex::indexModule(Module &M, uint32_t fileIdx, vector<IndexedFunc> &res)
+{
+    for (Function &F : M)
+    {
+        if (!F.isIntrinsic() && F.hasAddressTaken(nullptr, false, true, true))
+        {
+            this->files[fileIdx].addrTakenFuncs.push_back(std::make_pair(IndirectCallResolver::hashType(F.getFunctionType()), F.getName().str()));
+        }
+        if (F.isDeclaration())
+        {
+            continue;
+        }
+        char linkage;
+        if (F.hasExternalLinkage())
+        {
+            linkage = 'g';
+        }
+        else if (F.hasInternalLinkage())
+        {
+            linkage = 'i';
+        }
+        else if (F.hasWeakLinkage())
+        {
+            linkage = 'w';
+        }
+        else
+        {
+            continue;
+        }
+
+        IndexedFunc func(F.getName().str(), fileIdx, linkage);
+        set<string> callees;
+        set<uint64_t> indirectCallTypes;
+        for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I)
+        {
+            if (CallInst *CI = dyn_cast<CallInst>(&(*I)))
+            {
+                Function *calledFunc = getCalledFunction(CI);
+                if (calledFunc && !calledFunc->isIntrinsic())
+                {
+                    callees.insert(calledFunc->getName().str());
+                }
+                else if (!calledFunc)
+                {
+                    indirectCallTypes.insert(IndirectCallResolver::hashType(CI->getFunctionType()));
+                }
+            }
+        }
+        func.callees.assign(callees.begin(), callees.end());
+        func.indirectCallTypes.assign(indirectCallTypes.begin(), indirectCallTypes.end());
+        res.push_back(func);
+    }
+}
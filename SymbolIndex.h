@@ -0,0 +1,66 @@
+#pragma once
+
+#include "llvm/IR/Module.h"
+
+#include "BinaryCG.h"
+#include "CallGraph.h"
+
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// A bitcode file covered by the symbol index
+class IndexedFile
+{
+public:
+    std::string path;
+    uint64_t size;
+    int64_t mtime;
+    uint64_t hash; // hash of the file content, the key of invalidation
+    std::vector<std::pair<uint64_t, std::string>> addrTakenFuncs; // (type hash, name) of the functions whose address is taken in this file
+
+    IndexedFile(std::string path);
+};
+
+// A function definition covered by the symbol index
+class IndexedFunc
+{
+public:
+    std::string name;
+    uint32_t fileIdx;
+    char linkage; // 'g' for external, 'i' for internal, 'w' for weak
+    std::vector<std::string> callees; // directly called functions
+    std::vector<uint64_t> indirectCallTypes; // type hashes of its indirect calls, as IndirectCallResolver::hashType()
+
+    IndexedFunc(std::string name, uint32_t fileIdx, char linkage);
+};
+
+// On-disk index from function names to the bitcode files that define them.
+// It is built once per kernel build and refreshed for the files whose content changed,
+// so that a run only parses the files reachable from its entries
+class SymbolIndex
+{
+public:
+    // load the index from indexFilename, re-index new or changed input files and save it back
+    SymbolIndex(std::string indexFilename, std::vector<std::string> inputFilenames, uint32_t numThreads, std::ostream &out);
+
+    // files defining the functions reachable from rootFuncs within maxCallDepth, through direct calls or the call graph.
+    // With resolveIndirectCalls, indirect calls also reach the address-taken functions of their type, and the files
+    // taking their addresses are included, so that IndirectCallResolver finds the same candidates
+    std::vector<std::string> getRequiredFiles(std::vector<std::string> rootFuncs, const DSimpleCGMap &dSimpleCGMap, uint32_t maxCallDepth, bool resolveIndirectCalls);
+    std::vector<std::string> getRequiredFiles(std::vector<std::string> rootFuncs, const BinaryCG &binaryCG, uint32_t maxCallDepth, bool resolveIndirectCalls);
+
+private:
+    std::vector<IndexedFile> files;
+    std::vector<IndexedFunc> funcs;
+    std::multimap<std::string, uint32_t> name2Funcs; // function name -> indices into funcs
+
+    bool load(std::string indexFilename, std::map<std::string, IndexedFile> &oldFiles, std::multimap<std::string, IndexedFunc> &oldFuncs);
+    void save(std::string indexFilename);
+    // indirect callees of a function, appended to the vector
+    typedef std::function<void(const std::string &, std::vector<std::string> &)> IndirectCalleesGetter;
+    std::vector<std::string> collectRequiredFiles(std::vector<std::string> &rootFuncs, const IndirectCalleesGetter &getIndirectCallees, uint32_t maxCallDepth, bool resolveIndirectCalls);
+    void indexModule(llvm::Module &M, uint32_t fileIdx, std::vector<IndexedFunc> &res);
+};
@@ -1,3 +1,4 @@
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/DebugLoc.h"
 #include "llvm/IR/InstIterator.h"
@@ -6,6 +7,8 @@
 
 #include "Utils.h"
 
+#include <memory>
+
 using namespace llvm;
 using namespace std;
 
@@ -34,16 +37,19 @@ string getName(Value *value, bool shortName)
     }
 }
 
-bool overlap(int64_t start1, int64_t end1, int64_t start2, int64_t end2)
+int64_t getExtentEnd(int64_t start, int64_t end)
 {
-    if (end1 == -1)
+    if (end == -1)
     {
-        end1 = start1 + 10000; // TODO
-    }
-    if (end2 == -1)
-    {
-        end2 = start2 + 10000; // TODO
+        return start + 10000; // unknown length on an object of unknown size, or starting past its end
     }
+    return end;
+}
+
+bool overlap(int64_t start1, int64_t end1, int64_t start2, int64_t end2)
+{
+    end1 = getExtentEnd(start1, end1);
+    end2 = getExtentEnd(start2, end2);
     return start1 < end2 && start2 < end1;
 }
 
@@ -69,28 +75,6 @@ string trimName(string name)
     return name;
 }
 
-vector<Instruction *> getAllInstsAtSrcLine(llvm::Function *F, string filename, uint32_t line)
-{
-    vector<Instruction *> insts;
-    for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
-        llvm::DebugLoc dbgloc = (*I).getDebugLoc();
-
-        // The instruction has DebugLoc
-        if(dbgloc)
-        {
-            string fn = dbgloc->getFilename().str();
-            uint32_t ln = dbgloc->getLine();
-
-            // match file name and line
-            if(fn == filename && ln == line)
-            {
-                insts.push_back(&(*I));
-            }
-        }
-    }
-    return insts;
-}
-
 tuple<string, uint32_t> getInstFileAndLine(llvm::Instruction *I)
 {
     llvm::DebugLoc dbgloc = I->getDebugLoc();
@@ -153,3 +137,14 @@ Function *getCalledFunction(CallInst *CI)
     }
     return calledFunc;
 }
+
+const DataLayout &getThreadDataLayout(const Module *M)
+{
+    static thread_local DenseMap<const Module *, unique_ptr<DataLayout>> module2DataLayout;
+    unique_ptr<DataLayout> &dataLayout = module2DataLayout[M];
+    if (!dataLayout)
+    {
+        dataLayout.reset(new DataLayout(M->getDataLayout()));
+    }
+    return *dataLayout;
+}
@@ -1,7 +1,9 @@
 #pragma once
 
+#include "llvm/IR/DataLayout.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
 #include "llvm/IR/Value.h"
 
 #include <set>
@@ -11,9 +13,9 @@
 
 // sometimes Value::getName returns an empty string, so we need to use raw_string_ostream to get its name
 std::string getName(llvm::Value *value, bool shortName = true);
-bool overlap(int64_t start1, int64_t end1, int64_t start2, int64_t end2);
+int64_t getExtentEnd(int64_t start, int64_t end); // end, or the default extent of an unknown end (-1)
+bool overlap(int64_t start1, int64_t end1, int64_t start2, int64_t end2); // an unknown end extends as getExtentEnd()
 std::string trimName(std::string name);
-std::vector<llvm::Instruction *> getAllInstsAtSrcLine(llvm::Function *F, std::string filename, uint32_t line);
 
 // get the filename and the line number of an instruction
 std::tuple<std::string, uint32_t> getInstFileAndLine(llvm::Instruction *I);
@@ -26,3 +28,7 @@ bool storesSensinfo(llvm::StoreInst *storeInst);
 
 // get called function from the callInst
 llvm::Function *getCalledFunction(llvm::CallInst *CI);
+
+// the data layout of M for the current thread. DataLayout caches struct layouts without a lock, so threads that
+// query the same module use their own copies
+const llvm::DataLayout &getThreadDataLayout(const llvm::Module *M);
@@ -1,4 +1,5 @@
 #include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Operator.h"
@@ -18,12 +19,12 @@ using namespace std;
 
 extern uint32_t maxCallDepth;
 
-FunctionVisitor::FunctionVisitor(GlobalState &glbState, Context context, const CGMap &callGraph, PointsToRecords &ptoRecords, DDG &ddg) : glbState(glbState), context(context), callGraph(callGraph), ptoRecords(ptoRecords), ddg(ddg)
+FunctionVisitor::FunctionVisitor(GlobalState &glbState, Context context, IndirectCallGraph &callGraph, const IndirectCallResolver *indirectCallResolver, FunctionSummaryCache *summaryCache, ObjectManager &objMgr, PointsToRecords &ptoRecords, DDG &ddg) : glbState(glbState), context(context), callGraph(callGraph), indirectCallResolver(indirectCallResolver), summaryCache(summaryCache), objMgr(objMgr), ptoRecords(ptoRecords), ddg(ddg)
 #ifdef NUM_VISITED_BBS
 , numVisitedBBs(0)
 #endif
 {
-    this->dataLayout = &context.entry->getParent()->getDataLayout();
+    this->dataLayout = &getThreadDataLayout(context.getEntry()->getParent());
 }
 
 void FunctionVisitor::analyze()
@@ -47,11 +48,11 @@ void FunctionVisitor::visitAllocaInst(AllocaInst &allocaInst)
     // new object
     Type *allocatedType = allocaInst.getAllocatedType();
     uint64_t typeSize = this->dataLayout->getTypeStoreSize(allocatedType);
-    ObjId objId = ObjectManager::createStackObject(typeSize);
+    ObjId objId = this->objMgr.createStackObject(typeSize);
 
     // update pto records for allocaInst
     ObjLoc pointee(objId, 0); // must point to object start
-    this->ptoRecords.addPteesForValPtr(this->context, &allocaInst, set<ObjLoc>{pointee});
+    this->ptoRecords.addPteesForValPtr(this->context, &allocaInst, PteeSetManager::getSingleton(pointee));
 }
 
 void FunctionVisitor::visitBinaryOperator(BinaryOperator &biOp)
@@ -69,13 +70,13 @@ void FunctionVisitor::visitPHINode(llvm::PHINode &phiNode)
 {
     // merge all ptees of incoming values
     set<Value *> incomingValues;
-    set<ObjLoc> phiNodePtees;
+    PteeSetId phiNodePtees = PteeSetManager::emptySet;
     for (unsigned i = 0; i < phiNode.getNumIncomingValues(); ++i) {
         Value *val = phiNode.getIncomingValue(i);
         incomingValues.insert(val);
 
-        set<ObjLoc> valPtees = getPteesOfValPtr(this->dataLayout, this->ptoRecords, this->context, val, false);
-        phiNodePtees.insert(valPtees.begin(), valPtees.end());
+        PteeSetId valPtees = getPteesOfValPtr(this->dataLayout, this->objMgr, this->ptoRecords, this->context, val, false);
+        phiNodePtees = PteeSetManager::unite(phiNodePtees, valPtees);
     }
 
     // update pto records for phiNode
@@ -91,17 +92,17 @@ void FunctionVisitor::visitLoadInst(LoadInst &loadInst)
 
     // get src ptees
     // create a dummy pointee if no src ptees
-    set<ObjLoc> srcPtees = getPteesOfValPtr(this->dataLayout, this->ptoRecords, this->context, src, true);
+    PteeSetId srcPtees = getPteesOfValPtr(this->dataLayout, this->objMgr, this->ptoRecords, this->context, src, true);
 
     // get ptees of src ptees
     // create a dummy pointee if the loadInst loads a pointer
     bool createDummyPointee = loadInst.getType()->isPointerTy();
     InstLoc currLoc = InstLoc(this->context, &loadInst);
-    set<ObjLoc> srcPteesPtees;
-    for (ObjLoc srcPtee : srcPtees)
+    PteeSetId srcPteesPtees = PteeSetManager::emptySet;
+    for (ObjLoc srcPtee : PteeSetManager::get(srcPtees))
     {
-        set<ObjLoc> srcPteePtees = getPteesOfObjPtr(this->ptoRecords, srcPtee, currLoc, createDummyPointee, currLoc);
-        srcPteesPtees.insert(srcPteePtees.begin(), srcPteePtees.end());
+        PteeSetId srcPteePtees = getPteesOfObjPtr(this->objMgr, this->ptoRecords, srcPtee, currLoc, createDummyPointee, currLoc);
+        srcPteesPtees = PteeSetManager::unite(srcPteesPtees, srcPteePtees);
     }
 
     // update pto records for loadInst
@@ -109,7 +110,51 @@ void FunctionVisitor::visitLoadInst(LoadInst &loadInst)
 
     // DDG
     uint64_t loadSize = this->dataLayout->getTypeStoreSize(loadInst.getType());
-    processLoad(this->ddg, this->context, srcPtees, &loadInst, src, loadSize);
+    processLoad(this->ddg, this->context, PteeSetManager::get(srcPtees), &loadInst, src, loadSize);
+}
+
+// whether a value of type ty holds an array, whose elements a variable index collapses into one slot
+static bool containsArray(Type *ty)
+{
+    if (isa<ArrayType>(ty) || isa<VectorType>(ty))
+    {
+        return true;
+    }
+    if (StructType *structTy = dyn_cast<StructType>(ty))
+    {
+        for (Type *elementTy : structTy->elements())
+        {
+            if (containsArray(elementTy))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// whether pointer addresses a single known slot of a stack or global object: it is derived from the object through
+// constant GEP indices only, and the object holds no array, so no access with a variable index can alias another slot
+static bool isFixedSlot(Value *pointer)
+{
+    pointer = pointer->stripPointerCasts();
+    while (GEPOperator *gep = dyn_cast<GEPOperator>(pointer))
+    {
+        if (!gep->hasAllConstantIndices())
+        {
+            return false;
+        }
+        pointer = gep->getPointerOperand()->stripPointerCasts();
+    }
+    if (AllocaInst *allocaInst = dyn_cast<AllocaInst>(pointer))
+    {
+        return !allocaInst->isArrayAllocation() && !containsArray(allocaInst->getAllocatedType());
+    }
+    if (GlobalVariable *glbVar = dyn_cast<GlobalVariable>(pointer))
+    {
+        return !containsArray(glbVar->getValueType());
+    }
+    return false;
 }
 
 void FunctionVisitor::visitStoreInst(StoreInst &storeInst)
@@ -120,17 +165,24 @@ void FunctionVisitor::visitStoreInst(StoreInst &storeInst)
     // get val ptees
     // create a dummy pointee if the storeInst stores a pointer that has no pointee
     bool createDummyPointee = val->getType()->isPointerTy();
-    set<ObjLoc> valPtees = getPteesOfValPtr(this->dataLayout, this->ptoRecords, this->context, val, createDummyPointee);
+    PteeSetId valPtees = getPteesOfValPtr(this->dataLayout, this->objMgr, this->ptoRecords, this->context, val, createDummyPointee);
 
     // get dst ptees
     // create a dummy pointee if no dst ptees
-    set<ObjLoc> dstPtees = getPteesOfValPtr(this->dataLayout, this->ptoRecords, this->context, dst, true);
+    ArrayRef<ObjLoc> dstPtees = PteeSetManager::get(getPteesOfValPtr(this->dataLayout, this->objMgr, this->ptoRecords, this->context, dst, true));
 
     // update pto records for dst ptees
+    // a single stack or global destination is overwritten for sure, if its offset is exact
     InstLoc currLoc = InstLoc(this->context, &storeInst);
+    bool strongUpdate = false;
+    if (dstPtees.size() == 1 && isFixedSlot(dst))
+    {
+        Kind kind = ObjectManager::getObjectKind(dstPtees.front().objId);
+        strongUpdate = kind == stack || kind == global;
+    }
     for (ObjLoc dstPtee : dstPtees)
     {
-        this->ptoRecords.addPteesForObjPtr(dstPtee, valPtees, currLoc);
+        this->ptoRecords.addPteesForObjPtr(dstPtee, valPtees, currLoc, strongUpdate);
     }
 
     // DDG
@@ -146,11 +198,11 @@ void FunctionVisitor::visitMemCpyInst(MemCpyInst &memCpyInst)
 
     // get src ptees
     // create a dummy pointee if no src ptees
-    set<ObjLoc> srcPtees = getPteesOfValPtr(this->dataLayout, this->ptoRecords, this->context, src, true);
+    ArrayRef<ObjLoc> srcPtees = PteeSetManager::get(getPteesOfValPtr(this->dataLayout, this->objMgr, this->ptoRecords, this->context, src, true));
 
     // get dst ptees
     // create a dummy pointee if no dst ptees
-    set<ObjLoc> dstPtees = getPteesOfValPtr(this->dataLayout, this->ptoRecords, this->context, dst, true);
+    ArrayRef<ObjLoc> dstPtees = PteeSetManager::get(getPteesOfValPtr(this->dataLayout, this->objMgr, this->ptoRecords, this->context, dst, true));
 
     // TODO: update pto records. However, this is rare for memcpy
 
@@ -195,14 +247,8 @@ void FunctionVisitor::visitGetElementPtrInst(GetElementPtrInst &gepInst)
 
     // get ptr ptees
     // create a dummy pointee if the castInst cast a pointer that has no pointee
-    set<ObjLoc> ptrPtees = getPteesOfValPtr(this->dataLayout, this->ptoRecords, this->context, ptr, true);
-    set<ObjLoc> gepPtees;
-    for (const ObjLoc &ptrPtee : ptrPtees)
-    {
-        // shift offset
-        ObjLoc gepPtee(ptrPtee.objId, ptrPtee.offset + offset);
-        gepPtees.insert(gepPtee);
-    }
+    PteeSetId ptrPtees = getPteesOfValPtr(this->dataLayout, this->objMgr, this->ptoRecords, this->context, ptr, true);
+    PteeSetId gepPtees = PteeSetManager::shift(ptrPtees, offset);
 
     // set ptr ptees
     this->ptoRecords.addPteesForValPtr(this->context, &gepInst, gepPtees);
@@ -218,7 +264,7 @@ void FunctionVisitor::visitCastInst(CastInst &castInst)
     // create a dummy pointee if no src ptees and castInst is a pointer
     bool createDummyPointee = castInst.getType()->isPointerTy();
 
-    set<ObjLoc> srcPtees = getPteesOfValPtr(this->dataLayout, this->ptoRecords, this->context, src, createDummyPointee);
+    PteeSetId srcPtees = getPteesOfValPtr(this->dataLayout, this->objMgr, this->ptoRecords, this->context, src, createDummyPointee);
     this->ptoRecords.addPteesForValPtr(this->context, &castInst, srcPtees);
 
     // DDG
@@ -237,14 +283,14 @@ void FunctionVisitor::visitCallInst(CallInst &callInst)
     else
     {
         Function *currFunc = this->context.getCurrentFunction();
-        std::pair<Function *, CallInst *> caller(currFunc, &callInst);
-        if (this->callGraph.find(caller) != this->callGraph.end())
-        {
-            calledFuncs = this->callGraph.at(caller);
-        }
-        else
+        if (!this->callGraph.getCallees(currFunc, &callInst, calledFuncs))
         {
-            return; // return if no called function found
+            if (!this->indirectCallResolver)
+            {
+                return; // return if no called function found
+            }
+            ArrayRef<Function *> callees = this->indirectCallResolver->getCallees(callInst); // match by function type
+            calledFuncs.insert(callees.begin(), callees.end());
         }
     }
 
@@ -267,6 +313,27 @@ static set<string> initHookedFuncNames()
 
 static set<string> hookedFuncNames = initHookedFuncNames(); // all hooked functions
 
+// the size allocated by a kernel allocation function: the constant size argument, or else the struct the result is cast to
+static offset_t getAllocationSize(const DataLayout *dataLayout, CallInst &callInst)
+{
+    if (ConstantInt *constantInt = dyn_cast<ConstantInt>(callInst.getArgOperand(0)))
+    {
+        return constantInt->getSExtValue();
+    }
+    for (User *user : callInst.users())
+    {
+        if (BitCastInst *castInst = dyn_cast<BitCastInst>(user))
+        {
+            PointerType *ptrType = dyn_cast<PointerType>(castInst->getType());
+            if (ptrType && !ptrType->isOpaque() && isa<StructType>(ptrType->getPointerElementType()) && !cast<StructType>(ptrType->getPointerElementType())->isOpaque())
+            {
+                return dataLayout->getTypeAllocSize(ptrType->getPointerElementType()); // not isSized(), which caches its result in the shared type
+            }
+        }
+    }
+    return -1;
+}
+
 void FunctionVisitor::handleCallFunction(CallInst &callInst, Function *calledFunc)
 {
     // intrinsic funciton
@@ -282,14 +349,14 @@ void FunctionVisitor::handleCallFunction(CallInst &callInst, Function *calledFun
         {
             if (kernelAllocations.find(calledFuncName) != kernelAllocations.end())
             {
-                ObjId objId = ObjectManager::createHeapObject(InstLoc(this->context, &callInst));
-                this->ptoRecords.addPteesForValPtr(this->context, &callInst, set<ObjLoc>{ObjLoc(objId, 0)});
+                ObjId objId = this->objMgr.createHeapObject(InstLoc(this->context, &callInst), getAllocationSize(this->dataLayout, callInst));
+                this->ptoRecords.addPteesForValPtr(this->context, &callInst, PteeSetManager::getSingleton(ObjLoc(objId, 0)));
             }
             else if (calledFuncName == "_copy_to_user")
             {
                 // from
                 Value *from = callInst.getArgOperand(1);
-                set<ObjLoc> fromPtees = getPteesOfValPtr(this->dataLayout, this->ptoRecords, this->context, from, true);
+                ArrayRef<ObjLoc> fromPtees = PteeSetManager::get(getPteesOfValPtr(this->dataLayout, this->objMgr, this->ptoRecords, this->context, from, true));
 
                 // n
                 Value *nVal = callInst.getArgOperand(2);
@@ -312,15 +379,15 @@ void FunctionVisitor::handleCallFunction(CallInst &callInst, Function *calledFun
 
                 arg++; // starting from argument 1
                 unsigned i = 0;
-                map<Value *, set<ObjLoc>> argPteesMap;
+                map<Value *, ArrayRef<ObjLoc>> argPteesMap;
                 for (; arg != argEnd; arg++, i++)
                 {
                     Value *argVal = (*arg).get();
                     if (isCopyOutFmtSpecs[i])
                     {
                         // copy out
-                        set<ObjLoc> argPtees = getPteesOfValPtr(this->dataLayout, this->ptoRecords, this->context, argVal, true);
-                        argPteesMap[argVal] = argPtees;
+                        PteeSetId argPtees = getPteesOfValPtr(this->dataLayout, this->objMgr, this->ptoRecords, this->context, argVal, true);
+                        argPteesMap[argVal] = PteeSetManager::get(argPtees);
                     }
                     else
                     {
@@ -343,7 +410,8 @@ void FunctionVisitor::handleCallFunction(CallInst &callInst, Function *calledFun
             }
             Context calleeCtx = this->context.add(&callInst, calledFunc);
 
-            // set up points-to for arguments and parameters
+            // get ptees of arguments
+            vector<PteeSetId> argPtees;
             User::op_iterator arg = callInst.arg_begin();
             User::op_iterator argEnd = callInst.arg_end();
             Function::arg_iterator parm = calledFunc->arg_begin();
@@ -354,21 +422,58 @@ void FunctionVisitor::handleCallFunction(CallInst &callInst, Function *calledFun
 
                 // create a dummy pointee if argVal is a pointer and it has no ptees
                 bool createDummyPointee = argVal->getType()->isPointerTy();
-                set<ObjLoc> argPtees = getPteesOfValPtr(this->dataLayout, this->ptoRecords, this->context, argVal, createDummyPointee);
+                argPtees.push_back(getPteesOfValPtr(this->dataLayout, this->objMgr, this->ptoRecords, this->context, argVal, createDummyPointee));
+            }
+
+            // reuse the analysis of calledFunc with the same argument ptees and loaded memory, which went as deep below it
+            uint32_t remainingDepth = maxCallDepth - this->context.getDepth();
+            if (this->summaryCache)
+            {
+                if (const FunctionSummary *summary = this->summaryCache->find(calledFunc, remainingDepth, argPtees, calleeCtx))
+                {
+                    this->summaryCache->apply(*summary, &callInst, this->context, calleeCtx);
+                    return;
+                }
+            }
+
+            // set up points-to for arguments and parameters
+            arg = callInst.arg_begin();
+            parm = calledFunc->arg_begin();
+            for (uint32_t i = 0; i < argPtees.size(); arg++, parm++, i++)
+            {
+                Value *argVal = (*arg).get();
 
                 // update pto records for parameters
-                this->ptoRecords.addPteesForValPtr(calleeCtx, &(*parm), argPtees);
+                this->ptoRecords.addPteesForValPtr(calleeCtx, &(*parm), argPtees[i]);
 
                 // DDG
                 processCall(this->ddg, this->context, argVal, calleeCtx, &(*parm));
             }
 
             // visit called function
-            FunctionVisitor vis(this->glbState, calleeCtx, this->callGraph, this->ptoRecords, this->ddg);
+            if (this->summaryCache)
+            {
+                this->summaryCache->beginSummary();
+            }
+            FunctionVisitor vis(this->glbState, calleeCtx, this->callGraph, this->indirectCallResolver, this->summaryCache, this->objMgr, this->ptoRecords, this->ddg);
             vis.analyze();
 #ifdef NUM_VISITED_BBS
             this->numVisitedBBs += vis.numVisitedBBs;
 #endif
+            if (this->summaryCache)
+            {
+                // ptees of the return value, as added to callInst by each returnInst
+                PteeSetId retPtees = PteeSetManager::emptySet;
+                for (inst_iterator I = inst_begin(calledFunc), E = inst_end(calledFunc); I != E; ++I)
+                {
+                    ReturnInst *retInst = dyn_cast<ReturnInst>(&*I);
+                    if (retInst && retInst->getReturnValue())
+                    {
+                        retPtees = PteeSetManager::unite(retPtees, getPteesOfValPtr(this->dataLayout, this->objMgr, this->ptoRecords, calleeCtx, retInst->getReturnValue(), false));
+                    }
+                }
+                this->summaryCache->addSummary(calledFunc, remainingDepth, argPtees, calleeCtx, retPtees);
+            }
         }
     }
 }
@@ -386,7 +491,7 @@ void FunctionVisitor::visitReturnInst(ReturnInst &retInst)
     {
         // create a dummy pointee if retVal is a pointer and it has no ptees
         bool createDummyPointee = retVal->getType()->isPointerTy();
-        set<ObjLoc> retValPtees = getPteesOfValPtr(this->dataLayout, this->ptoRecords, this->context, retVal, createDummyPointee);
+        PteeSetId retValPtees = getPteesOfValPtr(this->dataLayout, this->objMgr, this->ptoRecords, this->context, retVal, createDummyPointee);
 
         InstLoc callerInstLoc = this->context.getCallerInstLoc();
         this->ptoRecords.addPteesForValPtr(callerInstLoc.context, callerInstLoc.inst, retValPtees);
@@ -440,23 +545,23 @@ vector<bool> getIfIsCopyOutFmtSpec(string fmtStr)
     return res;
 }
 
-set<ObjLoc> getPteesOfValPtr(const DataLayout *dataLayout, PointsToRecords &ptoRecords, Context context, Value *pointer, bool createDummyPointee)
+PteeSetId getPteesOfValPtr(const DataLayout *dataLayout, ObjectManager &objMgr, PointsToRecords &ptoRecords, Context context, Value *pointer, bool createDummyPointee)
 {
     if (isa<Instruction>(pointer) || isa<Argument>(pointer))
     {
-        set<ObjLoc> pointees = ptoRecords.getPteesOfValPtr(context, pointer);
-        if (pointees.empty() && createDummyPointee)
+        PteeSetId pointees = ptoRecords.getPteesOfValPtr(context, pointer);
+        if (pointees == PteeSetManager::emptySet && createDummyPointee)
         {
-            ObjId objId = ObjectManager::createDummyObject();
-            pointees = set<ObjLoc>{ObjLoc(objId, 0)};
+            ObjId objId = objMgr.getOrCreateDummyObject(pointer);
+            pointees = PteeSetManager::getSingleton(ObjLoc(objId, 0));
             ptoRecords.addPteesForValPtr(context, pointer, pointees);
         }
         return pointees;
     }
     else if (GlobalVariable *glbVar = dyn_cast<GlobalVariable>(pointer))
     {
-        ObjId objId = ObjectManager::getOrCreateGlobalObject(glbVar);
-        return set<ObjLoc>{ObjLoc(objId, 0)};
+        ObjId objId = objMgr.getOrCreateGlobalObject(glbVar);
+        return PteeSetManager::getSingleton(ObjLoc(objId, 0));
     }
     else if (ConstantExpr *constantExpr = dyn_cast<ConstantExpr>(pointer))
     {
@@ -469,15 +574,8 @@ set<ObjLoc> getPteesOfValPtr(const DataLayout *dataLayout, PointsToRecords &ptoR
             bool success = gepOpr->accumulateConstantOffset(*dataLayout, ap_offset);
             assert(success);
             int64_t offset = ap_offset.getSExtValue();
-            set<ObjLoc> ptrPtees = getPteesOfValPtr(dataLayout, ptoRecords, context, gepOpr->getPointerOperand(), createDummyPointee);
-            set<ObjLoc> gepPtees;
-            for (ObjLoc ptrPtee : ptrPtees)
-            {
-                // shift offset
-                ObjLoc gepPtee(ptrPtee.objId, ptrPtee.offset + offset);
-                gepPtees.insert(gepPtee);
-            }
-            return gepPtees;
+            PteeSetId ptrPtees = getPteesOfValPtr(dataLayout, objMgr, ptoRecords, context, gepOpr->getPointerOperand(), createDummyPointee);
+            return PteeSetManager::shift(ptrPtees, offset);
             break;
         }
         case Instruction::BitCast:
@@ -516,16 +614,16 @@ set<ObjLoc> getPteesOfValPtr(const DataLayout *dataLayout, PointsToRecords &ptoR
         outs() << "unhandled value: " << *pointer << "\n";
         assert(0);
     }
-    return set<ObjLoc>();
+    return PteeSetManager::emptySet;
 }
 
-set<ObjLoc> getPteesOfObjPtr(PointsToRecords &ptoRecords, ObjLoc pointer, InstLoc currLoc, bool createDummyPointee, InstLoc dummyPtoUpdateLoc)
+PteeSetId getPteesOfObjPtr(ObjectManager &objMgr, PointsToRecords &ptoRecords, ObjLoc pointer, InstLoc currLoc, bool createDummyPointee, InstLoc dummyPtoUpdateLoc)
 {
-    set<ObjLoc> pointees = ptoRecords.getPteesOfObjPtr(pointer, currLoc);
-    if (pointees.empty() && createDummyPointee)
+    PteeSetId pointees = ptoRecords.getPteesOfObjPtr(pointer, currLoc);
+    if (pointees == PteeSetManager::emptySet && createDummyPointee)
     {
-        ObjId objId = ObjectManager::createDummyObject();
-        pointees = set<ObjLoc>{ObjLoc(objId, 0)};
+        ObjId objId = objMgr.getOrCreateDummyObject(currLoc.inst); // the pointee of the loaded pointer
+        pointees = PteeSetManager::getSingleton(ObjLoc(objId, 0));
         ptoRecords.addPteesForObjPtr(pointer, pointees, dummyPtoUpdateLoc);
     }
     return pointees;
@@ -5,7 +5,9 @@
 
 #include "CallGraph.h"
 #include "DDG.h"
+#include "FunctionSummary.h"
 #include "GlobalState.h"
+#include "IndirectCallResolver.h"
 #include "InstLoc.h"
 #include "PointsTo.h"
 
@@ -17,7 +19,10 @@ private:
     GlobalState &glbState;
     Context context;
     const llvm::DataLayout *dataLayout;
-    const CGMap &callGraph; // precomputed call graph
+    IndirectCallGraph &callGraph; // from the cg file
+    const IndirectCallResolver *indirectCallResolver; // resolves indirect calls missing in callGraph. Can be null
+    FunctionSummaryCache *summaryCache; // reuses the analysis of callees. Can be null
+    ObjectManager &objMgr;
     PointsToRecords &ptoRecords;
     DDG &ddg;
 #ifdef NUM_VISITED_BBS
@@ -25,7 +30,7 @@ private:
 #endif
 
 public:
-    FunctionVisitor(GlobalState &glbState, Context context, const CGMap &callGraph, PointsToRecords &ptoRecords, DDG &ddg);
+    FunctionVisitor(GlobalState &glbState, Context context, IndirectCallGraph &callGraph, const IndirectCallResolver *indirectCallResolver, FunctionSummaryCache *summaryCache, ObjectManager &objMgr, PointsToRecords &ptoRecords, DDG &ddg);
 
     void analyze();
     void visitAllocaInst(llvm::AllocaInst &allocaInst);
@@ -50,5 +55,5 @@ private:
 std::string getPrintkFmtStr(llvm::Value *printkFirstArg);
 std::vector<bool> getIfIsCopyOutFmtSpec(std::string fmtStr);
 
-std::set<ObjLoc> getPteesOfValPtr(const llvm::DataLayout *dataLayout, PointsToRecords &ptoRecords, Context context, llvm::Value *pointer, bool createDummyPointee);
-std::set<ObjLoc> getPteesOfObjPtr(PointsToRecords &ptoRecords, ObjLoc pointer, InstLoc currLoc, bool createDummyPointee, InstLoc dummyPtoUpdateLoc);
+PteeSetId getPteesOfValPtr(const llvm::DataLayout *dataLayout, ObjectManager &objMgr, PointsToRecords &ptoRecords, Context context, llvm::Value *pointer, bool createDummyPointee);
+PteeSetId getPteesOfObjPtr(ObjectManager &objMgr, PointsToRecords &ptoRecords, ObjLoc pointer, InstLoc currLoc, bool createDummyPointee, InstLoc dummyPtoUpdateLoc);
@@ -0,0 +1,21 @@
+file(REMOVE_RECURSE
+  "AllocSite"
+  "AllocSite.pdb"
+  "CMakeFiles/AllocSite.dir/AllocSite.cpp.o"
+  "CMakeFiles/AllocSite.dir/AllocSite.cpp.o.d"
+  "CMakeFiles/AllocSite.dir/Config.cpp.o"
+  "CMakeFiles/AllocSite.dir/Config.cpp.o.d"
+  "CMakeFiles/AllocSite.dir/GlobalState.cpp.o"
+  "CMakeFiles/AllocSite.dir/GlobalState.cpp.o.d"
+  "CMakeFiles/AllocSite.dir/MainAllocSite.cpp.o"
+  "CMakeFiles/AllocSite.dir/MainAllocSite.cpp.o.d"
+  "CMakeFiles/AllocSite.dir/ParseIR.cpp.o"
+  "CMakeFiles/AllocSite.dir/ParseIR.cpp.o.d"
+  "CMakeFiles/AllocSite.dir/Utils.cpp.o"
+  "CMakeFiles/AllocSite.dir/Utils.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/AllocSite.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
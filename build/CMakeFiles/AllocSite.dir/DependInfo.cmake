@@ -0,0 +1,24 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/AllocSite.cpp" "CMakeFiles/AllocSite.dir/AllocSite.cpp.o" "gcc" "CMakeFiles/AllocSite.dir/AllocSite.cpp.o.d"
+  "/root/repo/Config.cpp" "CMakeFiles/AllocSite.dir/Config.cpp.o" "gcc" "CMakeFiles/AllocSite.dir/Config.cpp.o.d"
+  "/root/repo/GlobalState.cpp" "CMakeFiles/AllocSite.dir/GlobalState.cpp.o" "gcc" "CMakeFiles/AllocSite.dir/GlobalState.cpp.o.d"
+  "/root/repo/MainAllocSite.cpp" "CMakeFiles/AllocSite.dir/MainAllocSite.cpp.o" "gcc" "CMakeFiles/AllocSite.dir/MainAllocSite.cpp.o.d"
+  "/root/repo/ParseIR.cpp" "CMakeFiles/AllocSite.dir/ParseIR.cpp.o" "gcc" "CMakeFiles/AllocSite.dir/ParseIR.cpp.o.d"
+  "/root/repo/Utils.cpp" "CMakeFiles/AllocSite.dir/Utils.cpp.o" "gcc" "CMakeFiles/AllocSite.dir/Utils.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "CGConvert"
+  "CGConvert.pdb"
+  "CMakeFiles/CGConvert.dir/BinaryCG.cpp.o"
+  "CMakeFiles/CGConvert.dir/BinaryCG.cpp.o.d"
+  "CMakeFiles/CGConvert.dir/MainCGConvert.cpp.o"
+  "CMakeFiles/CGConvert.dir/MainCGConvert.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/CGConvert.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,35 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/BinaryCG.cpp" "CMakeFiles/PAT.dir/BinaryCG.cpp.o" "gcc" "CMakeFiles/PAT.dir/BinaryCG.cpp.o.d"
+  "/root/repo/CallGraph.cpp" "CMakeFiles/PAT.dir/CallGraph.cpp.o" "gcc" "CMakeFiles/PAT.dir/CallGraph.cpp.o.d"
+  "/root/repo/Config.cpp" "CMakeFiles/PAT.dir/Config.cpp.o" "gcc" "CMakeFiles/PAT.dir/Config.cpp.o.d"
+  "/root/repo/DDG.cpp" "CMakeFiles/PAT.dir/DDG.cpp.o" "gcc" "CMakeFiles/PAT.dir/DDG.cpp.o.d"
+  "/root/repo/FunctionSummary.cpp" "CMakeFiles/PAT.dir/FunctionSummary.cpp.o" "gcc" "CMakeFiles/PAT.dir/FunctionSummary.cpp.o.d"
+  "/root/repo/GlobalState.cpp" "CMakeFiles/PAT.dir/GlobalState.cpp.o" "gcc" "CMakeFiles/PAT.dir/GlobalState.cpp.o.d"
+  "/root/repo/IndirectCallResolver.cpp" "CMakeFiles/PAT.dir/IndirectCallResolver.cpp.o" "gcc" "CMakeFiles/PAT.dir/IndirectCallResolver.cpp.o.d"
+  "/root/repo/InstLoc.cpp" "CMakeFiles/PAT.dir/InstLoc.cpp.o" "gcc" "CMakeFiles/PAT.dir/InstLoc.cpp.o.d"
+  "/root/repo/MainPAT.cpp" "CMakeFiles/PAT.dir/MainPAT.cpp.o" "gcc" "CMakeFiles/PAT.dir/MainPAT.cpp.o.d"
+  "/root/repo/Object.cpp" "CMakeFiles/PAT.dir/Object.cpp.o" "gcc" "CMakeFiles/PAT.dir/Object.cpp.o.d"
+  "/root/repo/ParseIR.cpp" "CMakeFiles/PAT.dir/ParseIR.cpp.o" "gcc" "CMakeFiles/PAT.dir/ParseIR.cpp.o.d"
+  "/root/repo/PointsTo.cpp" "CMakeFiles/PAT.dir/PointsTo.cpp.o" "gcc" "CMakeFiles/PAT.dir/PointsTo.cpp.o.d"
+  "/root/repo/SCC.cpp" "CMakeFiles/PAT.dir/SCC.cpp.o" "gcc" "CMakeFiles/PAT.dir/SCC.cpp.o.d"
+  "/root/repo/Shard.cpp" "CMakeFiles/PAT.dir/Shard.cpp.o" "gcc" "CMakeFiles/PAT.dir/Shard.cpp.o.d"
+  "/root/repo/SymbolIndex.cpp" "CMakeFiles/PAT.dir/SymbolIndex.cpp.o" "gcc" "CMakeFiles/PAT.dir/SymbolIndex.cpp.o.d"
+  "/root/repo/Utils.cpp" "CMakeFiles/PAT.dir/Utils.cpp.o" "gcc" "CMakeFiles/PAT.dir/Utils.cpp.o.d"
+  "/root/repo/Visitor.cpp" "CMakeFiles/PAT.dir/Visitor.cpp.o" "gcc" "CMakeFiles/PAT.dir/Visitor.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
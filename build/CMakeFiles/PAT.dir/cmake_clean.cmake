@@ -0,0 +1,43 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/PAT.dir/BinaryCG.cpp.o"
+  "CMakeFiles/PAT.dir/BinaryCG.cpp.o.d"
+  "CMakeFiles/PAT.dir/CallGraph.cpp.o"
+  "CMakeFiles/PAT.dir/CallGraph.cpp.o.d"
+  "CMakeFiles/PAT.dir/Config.cpp.o"
+  "CMakeFiles/PAT.dir/Config.cpp.o.d"
+  "CMakeFiles/PAT.dir/DDG.cpp.o"
+  "CMakeFiles/PAT.dir/DDG.cpp.o.d"
+  "CMakeFiles/PAT.dir/FunctionSummary.cpp.o"
+  "CMakeFiles/PAT.dir/FunctionSummary.cpp.o.d"
+  "CMakeFiles/PAT.dir/GlobalState.cpp.o"
+  "CMakeFiles/PAT.dir/GlobalState.cpp.o.d"
+  "CMakeFiles/PAT.dir/IndirectCallResolver.cpp.o"
+  "CMakeFiles/PAT.dir/IndirectCallResolver.cpp.o.d"
+  "CMakeFiles/PAT.dir/InstLoc.cpp.o"
+  "CMakeFiles/PAT.dir/InstLoc.cpp.o.d"
+  "CMakeFiles/PAT.dir/MainPAT.cpp.o"
+  "CMakeFiles/PAT.dir/MainPAT.cpp.o.d"
+  "CMakeFiles/PAT.dir/Object.cpp.o"
+  "CMakeFiles/PAT.dir/Object.cpp.o.d"
+  "CMakeFiles/PAT.dir/ParseIR.cpp.o"
+  "CMakeFiles/PAT.dir/ParseIR.cpp.o.d"
+  "CMakeFiles/PAT.dir/PointsTo.cpp.o"
+  "CMakeFiles/PAT.dir/PointsTo.cpp.o.d"
+  "CMakeFiles/PAT.dir/SCC.cpp.o"
+  "CMakeFiles/PAT.dir/SCC.cpp.o.d"
+  "CMakeFiles/PAT.dir/Shard.cpp.o"
+  "CMakeFiles/PAT.dir/Shard.cpp.o.d"
+  "CMakeFiles/PAT.dir/SymbolIndex.cpp.o"
+  "CMakeFiles/PAT.dir/SymbolIndex.cpp.o.d"
+  "CMakeFiles/PAT.dir/Utils.cpp.o"
+  "CMakeFiles/PAT.dir/Utils.cpp.o.d"
+  "CMakeFiles/PAT.dir/Visitor.cpp.o"
+  "CMakeFiles/PAT.dir/Visitor.cpp.o.d"
+  "PAT"
+  "PAT.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/PAT.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()